@@ -30,6 +30,15 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include <sstream>
 #include <iomanip>
 #include <any>
+#include <functional>
+#include <algorithm>
+#include <string_view>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstdlib>
 #include "liblc_typedefs.h"
 
 namespace liblc {
@@ -79,6 +88,189 @@ namespace liblc {
             std::string text;
     };
 
+    class ArgparseResponseFileException: public ArgparseCommonException {
+        public:
+            ArgparseResponseFileException(std::string path): text("Unable to read response file " + path) {}
+            virtual const char* what() const throw() {
+                return text.c_str();
+            }
+        private:
+            std::string text;
+    };
+
+    class ArgparseResponseFileCycle: public ArgparseCommonException {
+        public:
+            ArgparseResponseFileCycle(std::string path): text("Response file includes itself " + path) {}
+            virtual const char* what() const throw() {
+                return text.c_str();
+            }
+        private:
+            std::string text;
+    };
+
+    class ArgparseResponseFileDepth: public ArgparseCommonException {
+        public:
+            ArgparseResponseFileDepth(std::string path): text("Response files nested too deep " + path) {}
+            virtual const char* what() const throw() {
+                return text.c_str();
+            }
+        private:
+            std::string text;
+    };
+
+    /**
+     * Read-only mapping of a response file (@path).
+     * Tokens are whitespace separated and may be quoted with ' or ".
+     * Tokens are returned as views into the mapping, nothing is copied.
+     */
+    class ResponseFile {
+        public:
+            class Iterator {
+                public:
+                    Iterator(ResponseFile *file): file(file) {
+                        ++(*this);
+                    }
+
+                    std::string_view operator*() const {
+                        return token;
+                    }
+
+                    Iterator& operator++() {
+                        if (file && !file->next(token)) {
+                            file = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    bool operator!=(const Iterator &other) const {
+                        return file != other.file;
+                    }
+                private:
+                    ResponseFile *file;
+                    std::string_view token;
+            };
+
+            ResponseFile(std::string path): path(path) {
+                int fd = open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    throw ArgparseResponseFileException(path);
+                }
+
+                struct stat info;
+                if (fstat(fd, &info) != 0) {
+                    close(fd);
+                    throw ArgparseResponseFileException(path);
+                }
+
+                char *resolved = realpath(path.c_str(), nullptr);
+                if (resolved) {
+                    canonicalPath = resolved;
+                    free(resolved);
+                } else {
+                    canonicalPath = path;
+                }
+
+                size = info.st_size;
+                if (size > 0) {
+                    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapped == MAP_FAILED) {
+                        close(fd);
+                        throw ArgparseResponseFileException(path);
+                    }
+                    data = (const char*)mapped;
+                }
+                close(fd);
+            }
+
+            ResponseFile(const ResponseFile&) = delete;
+            ResponseFile& operator=(const ResponseFile&) = delete;
+
+            ~ResponseFile() {
+                if (data) {
+                    munmap((void*)data, size);
+                }
+            }
+
+            /**
+             * Reads the next token.
+             * Returns:
+             *  false if the end of the file was reached
+             */
+            bool next(std::string_view &token) {
+                if (isAtEnd()) {
+                    return false;
+                }
+
+                char quote = data[current];
+                if (quote == '"' || quote == '\'') {
+                    size_t start = ++current;
+                    while (current < size && data[current] != quote) {
+                        current++;
+                    }
+                    token = std::string_view(data+start, current-start);
+                    if (current < size) {
+                        current++; // closing quote
+                    }
+                } else {
+                    size_t start = current;
+                    while (current < size && !isSpace(data[current])) {
+                        current++;
+                    }
+                    token = std::string_view(data+start, current-start);
+                }
+                return true;
+            }
+
+            /**
+             * Skips whitespace.
+             * Returns:
+             *  true if no tokens are left
+             */
+            bool isAtEnd() {
+                while (current < size && isSpace(data[current])) {
+                    current++;
+                }
+                return current >= size;
+            }
+
+            Iterator begin() {
+                return Iterator(this);
+            }
+
+            Iterator end() {
+                return Iterator(nullptr);
+            }
+
+            std::string getPath() {
+                return path;
+            }
+
+            /**
+             * Returns:
+             *  the path with symlinks, . and .. resolved
+             */
+            const std::string& getCanonicalPath() const {
+                return canonicalPath;
+            }
+        private:
+            bool isSpace(char c) {
+                return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+            }
+
+            std::string path;
+            std::string canonicalPath;
+            const char *data = nullptr;
+            size_t size = 0;
+            size_t current = 0;
+    };
+
+    class ArgparseFrozen: public ArgparseCommonException {
+        public:
+            virtual const char* what() const throw() {
+                return "Parser schema is frozen";
+            }
+    };
+
     class Args {
         public:
             Args() {
@@ -154,6 +346,23 @@ namespace liblc {
                 return this->values.find(name) != this->values.end();
             }
 
+            void setSubcommand(std::string name, std::shared_ptr<Args> args) {
+                subcommand = name;
+                subcommandArgs = args;
+            }
+
+            /**
+             * Returns:
+             *  the name of the subcommand that was parsed or an empty string
+             */
+            std::string getSubcommand() {
+                return subcommand;
+            }
+
+            std::shared_ptr<Args> getSubcommandArgs() {
+                return subcommandArgs;
+            }
+
         private:
             template<typename T>
             void addGeneric(std::string name, T value) {
@@ -185,6 +394,8 @@ namespace liblc {
             }
 
             std::map<std::string, std::vector<std::any>> values;
+            std::string subcommand;
+            std::shared_ptr<Args> subcommandArgs;
     };
 
     /**
@@ -219,7 +430,19 @@ namespace liblc {
             bool isRequired() {
                 return required;
             }
+
+            /**
+             * Index of the argument in a frozen schema
+             */
+            size_t getId() {
+                return id;
+            }
+
+            void setId(size_t id) {
+                this->id = id;
+            }
         private:
+            size_t id = 0;
             int nargs;
             std::string help;
             bool unique;
@@ -282,6 +505,42 @@ namespace liblc {
             }
     };
 
+    typedef std::function<void(std::string_view)> ArgConsumerCallback;
+
+    struct ArgparseStats;
+    typedef std::function<void(const ArgparseStats&)> ArgparseStatsCallback;
+
+    /**
+     * Statistics of Argparse::parse, values accumulate until reset.
+     * tokens and bytes include response file contents but not the program name.
+     */
+    struct ArgparseStats {
+        std::chrono::nanoseconds parseTime{0};
+        size_t tokens = 0;
+        size_t bytes = 0;
+        size_t arguments = 0;
+        size_t positionals = 0;
+        size_t responseFiles = 0;
+        size_t subcommands = 0;
+        // called after each parse
+        ArgparseStatsCallback callback;
+
+        void report() {
+            if (callback) {
+                callback(*this);
+            }
+        }
+
+        void reset() {
+            auto keep = callback;
+            *this = ArgparseStats();
+            callback = keep;
+        }
+    };
+
+    class Argparse;
+    typedef std::function<void(Argparse&)> ArgSubcommandFactory;
+
     class Argparse {
         public:
             Argparse(std::string description, std::ostream &out=std::cout):
@@ -293,62 +552,242 @@ namespace liblc {
 
             void addArgument(std::string name, ArgparseType type,
                     int nargs=1, std::string help="", std::string shortName="", bool unique=false, bool required=false) {
+                ensureNotFrozen();
                 args[name] = makeParser(name, type, nargs, help, unique, required);
 
                 if (shortName != "") {
                     shortNames[shortName] = name;
                 }
+                completionIndex.clear();
             }
 
             void addConsumer(std::string name, ArgparseType type, std::string help, bool required=false) {
+                ensureNotFrozen();
                 consumer = makeParser(name, type, -1, help, true, required);
                 consumerName = name;
+                consumerCallback = nullptr;
             }
 
-            Args parse(int argc, char **argv) {
-                Args resultArgs;
-                this->argc = argc;
-                this->argv = argv;
-                this->index = 0;
-                bool consumedDefault = false;
+            /**
+             * Adds a consumer that streams every value to callback
+             * instead of storing it in Args.
+             * The view is only valid for the duration of the call.
+             */
+            void addConsumer(std::string name, std::string help, ArgConsumerCallback callback, bool required=false) {
+                ensureNotFrozen();
+                consumer = makeParser(name, STRING, -1, help, true, required);
+                consumerName = name;
+                consumerCallback = callback;
+            }
 
-                if (argc > 0) {
-                    progName = next();
+            /**
+             * Turns the parser into an immutable schema.
+             * Builds the long to short name index, the required argument set
+             * and caches the help text.
+             * Any further add call throws ArgparseFrozen.
+             */
+            void freeze() {
+                if (frozen) {
+                    return;
                 }
 
-                // iterate over all argvs and attempt to parse them
-                while (!isAtEnd()) {
-                    std::string name = next();
-                    if (!parseArgument(name, &resultArgs)) {
-                        if (consumer.get() == nullptr) {
-                            throw ArgparseInvalidArgument(name);
-                        } else {
-                            consumer->parse(name, consumerName, &resultArgs);
-                            consumedDefault = true;
+                longNames.clear();
+                requiredIds.clear();
+                for (auto it = shortNames.begin(); it != shortNames.end(); it++) {
+                    longNames[it->second] = it->first;
+                }
+
+                size_t id = 0;
+                for (auto it = args.begin(); it != args.end(); it++, id++) {
+                    it->second->setId(id);
+                    if (it->second->isRequired()) {
+                        requiredIds.push_back(id);
+                    }
+                }
+                seen.assign(args.size(), false);
+                frozen = true;
+            }
+
+            bool isFrozen() {
+                return frozen;
+            }
+
+            /**
+             * Returns:
+             *  the short name of an argument or an empty string
+             */
+            std::string getShortName(std::string name) {
+                if (frozen) {
+                    auto found = longNames.find(name);
+                    return found != longNames.end() ? found->second : "";
+                }
+
+                std::string shortName = "";
+                for (auto it = shortNames.begin(); it != shortNames.end(); it++) {
+                    if (it->second == name) {
+                        shortName = it->first;
+                    }
+                }
+                return shortName;
+            }
+
+            /**
+             * Registers a subcommand.
+             * factory is only called when name appears in argv and
+             * receives a new parser for the remaining arguments.
+             */
+            void addSubcommand(std::string name, std::string help, ArgSubcommandFactory factory) {
+                ensureNotFrozen();
+                subcommands[name] = std::make_pair(help, factory);
+                completionIndex.clear();
+            }
+
+            /**
+             * Returns:
+             *  the parser built for the last parsed subcommand or nullptr
+             */
+            std::shared_ptr<Argparse> getSubcommandParser() {
+                return subcommandParser;
+            }
+
+            /**
+             * Enables shell completion.
+             * If flag is the first argument the remaining arguments are
+             * treated as <shell> <words...> and completion candidates for the
+             * last word are printed instead of parsing.
+             * Supported shells are bash, zsh and fish.
+             */
+            void enableCompletion(std::string flag="--complete") {
+                completionFlag = flag;
+            }
+
+            /**
+             * Returns:
+             *  all names (and their help text) that start with the last word.
+             *  Subcommands in words are followed.
+             */
+            std::vector<std::pair<std::string, std::string>> complete(std::vector<std::string> words) {
+                std::string prefix = words.size() > 0 ? words.back() : "";
+
+                for (size_t i = 0; i + 1 < words.size(); i++) {
+                    auto subcommand = subcommands.find(words[i]);
+                    if (subcommand != subcommands.end()) {
+                        Argparse subParser(subcommand->second.first, out);
+                        subcommand->second.second(subParser);
+                        return subParser.complete(std::vector<std::string>(words.begin()+i+1, words.end()));
+                    }
+                }
+
+                if (completionIndex.empty()) {
+                    buildCompletionIndex();
+                }
+
+                std::vector<std::pair<std::string, std::string>> result;
+                auto it = std::lower_bound(completionIndex.begin(), completionIndex.end(),
+                        std::make_pair(prefix, std::string("")));
+                for (; it != completionIndex.end() && it->first.compare(0, prefix.size(), prefix) == 0; it++) {
+                    result.push_back(*it);
+                }
+                return result;
+            }
+
+            std::string getCompletionText(std::string shell, std::vector<std::string> words) {
+                std::stringstream strstream;
+                auto candidates = complete(words);
+                for (auto it = candidates.begin(); it != candidates.end(); it++) {
+                    if (shell == "zsh") {
+                        // _describe format name:description
+                        for (char c : it->first) {
+                            if (c == ':') {
+                                strstream << '\\';
+                            }
+                            strstream << c;
                         }
-                    } else if (consumedDefault) {
-                        // error cannot consume default and then parse again!
-                        throw ArgparseInvalidArgument(name);
+                        strstream << ':' << it->second << std::endl;
+                    } else if (shell == "fish") {
+                        strstream << it->first << '\t' << it->second << std::endl;
+                    } else {
+                        strstream << it->first << std::endl;
                     }
                 }
+                return strstream.str();
+            }
 
-                // find any required arguments that did not receive an input
-                // if so throw!
-                ensureRequiredArgs(resultArgs);
+            /**
+             * If enabled any argument of the form @path is replaced
+             * by the tokens stored in path.
+             * Response files may contain @path themselves, up to maxDepth files deep.
+             * Throws while parsing:
+             *  ArgparseResponseFileCycle if a file includes itself
+             *  ArgparseResponseFileDepth if files are nested deeper than maxDepth
+             */
+            void setResponseFiles(bool enabled, size_t maxDepth=16) {
+                responseFilesEnabled = enabled;
+                responseFileDepth = maxDepth;
+            }
+
+            /**
+             * Collects statistics in stats, nullptr disables them.
+             * Subcommands are counted in the same stats.
+             */
+            void setStats(ArgparseStats *stats) {
+                this->stats = stats;
+            }
 
+            Args parse(int argc, char **argv) {
+                if (!stats) {
+                    return parseArgs(argc, argv);
+                }
 
-                return resultArgs;
+                auto start = std::chrono::steady_clock::now();
+                try {
+                    Args result = parseArgs(argc, argv);
+                    stats->parseTime += std::chrono::steady_clock::now() - start;
+                    stats->report();
+                    return result;
+                } catch (...) {
+                    stats->parseTime += std::chrono::steady_clock::now() - start;
+                    throw;
+                }
             }
 
-            char* next() {
-                return argv[index++];
+            std::string_view next() {
+                std::string_view token;
+                if (!isAtEnd() && !responseFiles.empty()) {
+                    responseFiles.back()->next(token);
+                } else {
+                    token = argv[index++];
+                }
+
+                if (stats) {
+                    stats->tokens++;
+                    stats->bytes += token.size();
+                }
+                return token;
             }
 
             bool isAtEnd() {
-                return index >= (unsigned long)argc;
+                // drop exhausted response files
+                while (!responseFiles.empty() && responseFiles.back()->isAtEnd()) {
+                    responseFiles.pop_back();
+                }
+                return responseFiles.empty() && index >= (unsigned long)argc;
             }
 
             std::string getHelpText() {
+                if (frozen && helpText.size() > 0 && helpProgName == progName) {
+                    return helpText;
+                }
+
+                // reverse index of short names
+                std::map<std::string, std::string> reverseShortNames;
+                if (!frozen) {
+                    for (auto it = shortNames.begin(); it != shortNames.end(); it++) {
+                        reverseShortNames[it->second] = it->first;
+                    }
+                }
+                auto &shortNameIndex = frozen ? longNames : reverseShortNames;
+
                 std::stringstream strstream;
 
                 strstream << description << std::endl << std::endl;
@@ -363,18 +802,28 @@ namespace liblc {
                 auto it = args.begin();
                 while (it != args.end()) {
                     std::string shortName = "";
-                    // search for shortname
-                    // map has no search so we need to be slow... ugh
-                    for (auto sit = shortNames.begin(); sit != shortNames.end(); ++sit) {
-                        if (sit->second == it->first) {
-                            shortName = sit->first;
-                        }
+                    auto found = shortNameIndex.find(it->first);
+                    if (found != shortNameIndex.end()) {
+                        shortName = found->second;
                     }
                     strstream << std::setw(10) << std::left << it->first << " " << shortName << "\t\t" << it->second->getHelp() << std::endl;
                     it++;
                 }
                 strstream << std::endl;
 
+                if (subcommands.size() > 0) {
+                    strstream << "Commands:" << std::endl;
+                    for (auto it = subcommands.begin(); it != subcommands.end(); it++) {
+                        strstream << std::setw(10) << std::left << it->first << "\t\t" << it->second.first << std::endl;
+                    }
+                    strstream << std::endl;
+                }
+
+                if (frozen) {
+                    helpText = strstream.str();
+                    helpProgName = progName;
+                    return helpText;
+                }
                 return strstream.str();
             }
 
@@ -382,6 +831,76 @@ namespace liblc {
                 return progName;
             }
         private:
+            Args parseArgs(int argc, char **argv) {
+                Args resultArgs;
+                this->argc = argc;
+                this->argv = argv;
+                this->index = 0;
+                this->responseFiles.clear();
+                this->subcommandParser = std::shared_ptr<Argparse>(nullptr);
+                if (frozen) {
+                    seen.assign(args.size(), false);
+                }
+                bool consumedDefault = false;
+
+                if (argc > 0) {
+                    progName = argv[index++];
+                }
+
+                if (completionFlag != "" && argc > 2 && completionFlag == argv[1]) {
+                    std::vector<std::string> words(argv+3, argv+argc);
+                    out << getCompletionText(argv[2], words);
+                    resultArgs.addBool(completionFlag, true);
+                    return resultArgs;
+                }
+
+                // iterate over all argvs and attempt to parse them
+                while (!isAtEnd()) {
+                    std::string_view name = next();
+                    if (responseFilesEnabled && name.size() > 1 && name[0] == '@') {
+                        openResponseFile(std::string(name.substr(1)));
+                        if (stats) {
+                            stats->responseFiles++;
+                        }
+                        continue;
+                    }
+
+                    std::string argName(name);
+                    if (!parseArgument(argName, &resultArgs)) {
+                        auto subcommand = subcommands.find(argName);
+                        if (subcommand != subcommands.end() && !consumedDefault && responseFiles.empty()) {
+                            resultArgs.setSubcommand(argName, parseSubcommand(subcommand->second));
+                            break;
+                        }
+
+                        if (consumer.get() == nullptr) {
+                            throw ArgparseInvalidArgument(argName);
+                        } else if (consumerCallback) {
+                            consumerCallback(name);
+                            consumedDefault = true;
+                        } else {
+                            consumer->parse(argName, consumerName, &resultArgs);
+                            consumedDefault = true;
+                        }
+                        if (stats) {
+                            stats->positionals++;
+                        }
+                    } else if (consumedDefault) {
+                        // error cannot consume default and then parse again!
+                        throw ArgparseInvalidArgument(argName);
+                    } else if (stats) {
+                        stats->arguments++;
+                    }
+                }
+
+                // find any required arguments that did not receive an input
+                // if so throw!
+                ensureRequiredArgs(resultArgs);
+
+
+                return resultArgs;
+            }
+
             std::shared_ptr<Parser> makeParser(std::string name, ArgparseType type,
                     int nargs, std::string help, bool unique, bool required) {
                 switch (type) {
@@ -402,6 +921,55 @@ namespace liblc {
                 return std::shared_ptr<Parser>(nullptr);
             }
 
+            void openResponseFile(const std::string &path) {
+                if (responseFiles.size() >= responseFileDepth) {
+                    throw ArgparseResponseFileDepth(path);
+                }
+
+                auto file = std::make_unique<ResponseFile>(path);
+                for (auto &open : responseFiles) {
+                    if (open->getCanonicalPath() == file->getCanonicalPath()) {
+                        throw ArgparseResponseFileCycle(path);
+                    }
+                }
+                responseFiles.push_back(std::move(file));
+            }
+
+            std::shared_ptr<Args> parseSubcommand(std::pair<std::string, ArgSubcommandFactory> &subcommand) {
+                subcommandParser = std::make_shared<Argparse>(subcommand.first, out);
+                subcommandParser->setResponseFiles(responseFilesEnabled, responseFileDepth);
+                subcommandParser->stats = stats;
+                if (stats) {
+                    stats->subcommands++;
+                }
+                subcommand.second(*subcommandParser);
+
+                // the subcommand's name becomes the program name of the sub parser
+                int subArgc = argc - index + 1;
+                char **subArgv = argv + index - 1;
+                index = argc;
+
+                // reported as part of this parse
+                return std::make_shared<Args>(subcommandParser->parseArgs(subArgc, subArgv));
+            }
+
+            void buildCompletionIndex() {
+                completionIndex.push_back(std::make_pair("--help", "Show this help"));
+                completionIndex.push_back(std::make_pair("-h", "Show this help"));
+                for (auto it = args.begin(); it != args.end(); it++) {
+                    completionIndex.push_back(std::make_pair(it->first, it->second->getHelp()));
+                }
+                for (auto it = shortNames.begin(); it != shortNames.end(); it++) {
+                    auto arg = args.find(it->second);
+                    completionIndex.push_back(std::make_pair(it->first,
+                                arg != args.end() ? arg->second->getHelp() : ""));
+                }
+                for (auto it = subcommands.begin(); it != subcommands.end(); it++) {
+                    completionIndex.push_back(std::make_pair(it->first, it->second.first));
+                }
+                std::sort(completionIndex.begin(), completionIndex.end());
+            }
+
             bool parseArgument(std::string name, Args *resultArgs) {
                 auto shortNameIt = shortNames.find(name);
                 if (shortNameIt != shortNames.end()) {
@@ -420,10 +988,15 @@ namespace liblc {
                     std::shared_ptr<Parser> parser = it->second;
 
                     // if is unique and result args already exist throw error
-                    if (parser->isUnique() && resultArgs->containsAny(name)) {
+                    bool wasSeen = frozen ? seen[parser->getId()] : resultArgs->containsAny(name);
+                    if (parser->isUnique() && wasSeen) {
                         throw ArgparseInvalidArgument(name);
                     }
 
+                    if (frozen) {
+                        seen[parser->getId()] = true;
+                    }
+
                     // parse amount of args we want
                     if (parser->getNargs() == 0) {
                         // set boolean
@@ -435,7 +1008,7 @@ namespace liblc {
                                 throw ArgparseInsufficientArguments();
                             }
                             // parse and add
-                            parser->parse(next(), name, resultArgs);
+                            parser->parse(std::string(next()), name, resultArgs);
                         }
                     }
                     return true;
@@ -443,7 +1016,16 @@ namespace liblc {
                 return false;
             }
 
-            void ensureRequiredArgs(Args resultArgs) {
+            void ensureRequiredArgs(Args &resultArgs) {
+                if (frozen) {
+                    for (auto id : requiredIds) {
+                        if (!seen[id]) {
+                            throw ArgparseMissingArgument(std::next(args.begin(), id)->first);
+                        }
+                    }
+                    return;
+                }
+
                 for (auto it = args.begin(); it != args.end(); it++) {
                     if (it->second->isRequired() && !resultArgs.containsAny(it->first)) {
                         throw ArgparseMissingArgument(it->first);
@@ -451,6 +1033,12 @@ namespace liblc {
                 }
             }
 
+            void ensureNotFrozen() {
+                if (frozen) {
+                    throw ArgparseFrozen();
+                }
+            }
+
             std::string progName;
 
             // those are set when parse is called
@@ -463,7 +1051,26 @@ namespace liblc {
             std::map<std::string, std::shared_ptr<Parser>> args;
             std::shared_ptr<Parser> consumer;
             std::string consumerName;
+            ArgConsumerCallback consumerCallback;
+            bool responseFilesEnabled = false;
+            size_t responseFileDepth = 16;
+            std::vector<std::unique_ptr<ResponseFile>> responseFiles;
             std::map<std::string, std::string> shortNames;
+            std::map<std::string, std::pair<std::string, ArgSubcommandFactory>> subcommands;
+            std::shared_ptr<Argparse> subcommandParser;
+            std::string completionFlag;
+            // sorted (name, help) pairs, built on first completion
+            std::vector<std::pair<std::string, std::string>> completionIndex;
+
+            // set by freeze
+            bool frozen = false;
+            std::map<std::string, std::string> longNames;
+            std::vector<size_t> requiredIds;
+            std::vector<bool> seen;
+            std::string helpText;
+            std::string helpProgName;
+
+            ArgparseStats *stats = nullptr;
     };
 };
 
@@ -0,0 +1,351 @@
+/*
+Copyright 2021 Lukas Krickl (lukas@krickl.dev)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction,
+including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",
+WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CONFIGBIND_H__
+#define __CONFIGBIND_H__
+
+#include <iostream>
+#include <map>
+#include <vector>
+#include <memory>
+#include <tuple>
+#include <optional>
+
+#include "configcc.h"
+
+namespace liblc {
+    /**
+     * Maps a config key to a member of T.
+     */
+    template<typename T, typename M>
+    struct ConfigField {
+        const char *name;
+        M T::*member;
+    };
+
+    template<typename T, typename M>
+    constexpr ConfigField<T, M> configField(const char *name, M T::*member) {
+        return ConfigField<T, M> { name, member };
+    }
+
+    /**
+     * Specialize for every struct that should be decoded.
+     * fields() returns a tuple of ConfigField.
+     * Use CONFIGCC_FIELDS to declare a specialization.
+     */
+    template<typename T>
+    struct ConfigFields;
+
+    class ConfigccDecodeError: public ConfigparseCommonException {
+        public:
+            ConfigccDecodeError(std::shared_ptr<Token> token, ErrorType error):
+                ConfigparseCommonException::ConfigparseCommonException(token, error) {}
+    };
+
+    /**
+     * Decodes a document straight into a struct without building
+     * a ConfigObject tree.
+     * Supported types are ConfigNumber, ConfigReal, double, ConfigBool, ConfigString,
+     * std::optional, std::vector, std::map with string keys and structs declared with
+     * CONFIGCC_FIELDS.
+     * Unknown keys are skipped, missing keys keep their value.
+     * Throws:
+     *  ConfigccDecodeError if a value has the wrong type
+     *  ConfigccParserError or ConfigccScannerError on syntax errors
+     *  ConfigccLimitError if the input exceeds limits
+     */
+    class ConfigDecoder {
+        public:
+            /**
+             * Skipped values are nested without recursion,
+             * limits.maxDepth applies to them as well.
+             */
+            ConfigDecoder(std::string data, std::string path="", ConfigLimits limits=ConfigLimits()):
+                scanner(data, path, limits), limits(limits) {
+                current = scanner.nextToken();
+            }
+
+            template<typename T>
+            void decode(T &target) {
+                read(target);
+                if (!isAtEnd()) {
+                    throw ConfigccParserError(current, EXPECTED_EOF);
+                }
+            }
+
+        private:
+            void read(ConfigNumber &target) {
+                int sign = readSign();
+                if (!check(NUMBER_TOKEN)) {
+                    throw ConfigccDecodeError(current, TYPE_ERROR);
+                }
+                target = advance()->getLiteral().toNumber() * sign;
+            }
+
+            void read(ConfigReal &target) {
+                int sign = readSign();
+                if (!check(NUMBER_TOKEN) && !check(REAL_TOKEN)) {
+                    throw ConfigccDecodeError(current, TYPE_ERROR);
+                }
+                target = advance()->getLiteral().toReal() * sign;
+            }
+
+            void read(double &target) {
+                ConfigReal value;
+                read(value);
+                target = value;
+            }
+
+            void read(ConfigBool &target) {
+                if (!check(TRUE) && !check(FALSE)) {
+                    throw ConfigccDecodeError(current, TYPE_ERROR);
+                }
+                target = advance()->getType() == TRUE;
+            }
+
+            void read(ConfigString &target) {
+                if (!check(STRING_TOKEN)) {
+                    throw ConfigccDecodeError(current, TYPE_ERROR);
+                }
+                target = advance()->getLiteral().toString();
+            }
+
+            template<typename T>
+            void read(std::optional<T> &target) {
+                if (check(NIL_TOKEN)) {
+                    advance();
+                    target.reset();
+                    return;
+                }
+                T value;
+                read(value);
+                target = value;
+            }
+
+            template<typename T>
+            void read(std::vector<T> &target) {
+                consumeStart(LEFT_BRACKET);
+                target.clear();
+                while (!check(RIGHT_BRACKET) && !isAtEnd()) {
+                    target.emplace_back();
+                    read(target.back());
+                    if (!check(RIGHT_BRACKET) || check(COMMA)) {
+                        consume(COMMA, EXPECTED_COMMA);
+                    }
+                }
+                consume(RIGHT_BRACKET, MISSING_RIGHT_BRACKET);
+                depth--;
+            }
+
+            template<typename T>
+            void read(std::map<std::string, T> &target) {
+                consumeStart(LEFT_BRACE);
+                target.clear();
+                while (!check(RIGHT_BRACE) && !isAtEnd()) {
+                    std::string key = readKey();
+                    read(target[key]);
+                    if (!check(RIGHT_BRACE) || check(COMMA)) {
+                        consume(COMMA, EXPECTED_COMMA);
+                    }
+                }
+                consume(RIGHT_BRACE, MISSING_RIGHT_BRACE);
+                depth--;
+            }
+
+            template<typename T>
+            void read(T &target) {
+                auto fields = ConfigFields<T>::fields();
+
+                consumeStart(LEFT_BRACE);
+                while (!check(RIGHT_BRACE) && !isAtEnd()) {
+                    std::string key = readKey();
+                    bool found = std::apply([&](auto&... field) {
+                        return (readField(target, field, key) || ...);
+                    }, fields);
+
+                    if (!found) {
+                        skip();
+                    }
+
+                    if (!check(RIGHT_BRACE) || check(COMMA)) {
+                        consume(COMMA, EXPECTED_COMMA);
+                    }
+                }
+                consume(RIGHT_BRACE, MISSING_RIGHT_BRACE);
+                depth--;
+            }
+
+            template<typename T, typename F>
+            bool readField(T &target, F &field, const std::string &key) {
+                if (key != field.name) {
+                    return false;
+                }
+                read(target.*(field.member));
+                return true;
+            }
+
+            /**
+             * Reads name = and returns name
+             */
+            std::string readKey() {
+                std::string key;
+                if (check(SECTION_NAME)) {
+                    key = advance()->getLexeme();
+                } else if (check(STRING_TOKEN)) {
+                    key = advance()->getLiteral().toString();
+                } else {
+                    throw ConfigccParserError(current, EXPECTED_SECTION_NAME);
+                }
+                consume(EQUAL, EXPECTED_EQUAL);
+                return key;
+            }
+
+            int readSign() {
+                if (check(MINUS)) {
+                    advance();
+                    return -1;
+                } else if (check(PLUS)) {
+                    advance();
+                }
+                return 1;
+            }
+
+            /**
+             * Skips a value of any type.
+             * Unknown keys come from the input, so open containers
+             * are kept on an explicit stack instead of recursing.
+             */
+            void skip() {
+                // closing token of every open container
+                std::vector<TokenType> open;
+                bool value = true;
+                while (true) {
+                    if (value && (check(LEFT_BRACE) || check(LEFT_BRACKET))) {
+                        enter();
+                        open.push_back(advance()->getType() == LEFT_BRACE ? RIGHT_BRACE : RIGHT_BRACKET);
+                    } else if (value) {
+                        skipScalar();
+                        if (open.empty()) {
+                            return;
+                        }
+                        consumeSeparator(open.back());
+                    }
+
+                    if (check(open.back()) || isAtEnd()) {
+                        consume(open.back(), open.back() == RIGHT_BRACE ? MISSING_RIGHT_BRACE : MISSING_RIGHT_BRACKET);
+                        open.pop_back();
+                        depth--;
+                        if (open.empty()) {
+                            return;
+                        }
+                        // the closed container was an element of the enclosing one
+                        consumeSeparator(open.back());
+                        value = false;
+                        continue;
+                    }
+
+                    if (open.back() == RIGHT_BRACE) {
+                        readKey();
+                    }
+                    value = true;
+                }
+            }
+
+            void consumeSeparator(TokenType closing) {
+                if (!check(closing) || check(COMMA)) {
+                    consume(COMMA, EXPECTED_COMMA);
+                }
+            }
+
+            void skipScalar() {
+                if (check(TRUE) || check(FALSE) || check(NIL_TOKEN) || check(STRING_TOKEN)) {
+                    advance();
+                } else {
+                    readSign();
+                    if (!check(NUMBER_TOKEN) && !check(REAL_TOKEN)) {
+                        throw ConfigccParserError(current, UNEXPECTED_TOKEN);
+                    }
+                    advance();
+                }
+            }
+
+            // start of a list or section is a type error rather than a syntax error
+            void consumeStart(TokenType type) {
+                if (!check(type)) {
+                    throw ConfigccDecodeError(current, TYPE_ERROR);
+                }
+                enter();
+                advance();
+            }
+
+            void enter() {
+                if (limits.maxDepth && depth >= limits.maxDepth) {
+                    throw ConfigccLimitError(current, DEPTH_LIMIT_EXCEEDED);
+                }
+                depth++;
+            }
+
+            void consume(TokenType type, ErrorType error) {
+                if (!check(type)) {
+                    throw ConfigccParserError(current, error);
+                }
+                advance();
+            }
+
+            bool check(TokenType type) {
+                return !isAtEnd() && current->getType() == type;
+            }
+
+            bool isAtEnd() {
+                return current->getType() == EOF_T;
+            }
+
+            std::shared_ptr<Token> advance() {
+                auto previous = current;
+                if (!isAtEnd()) {
+                    current = scanner.nextToken();
+                }
+                return previous;
+            }
+
+            ConfigScanner scanner;
+            std::shared_ptr<Token> current;
+            ConfigLimits limits;
+            size_t depth = 0;
+    };
+}
+
+#define CONFIGCC_FIELD(type, member) liblc::configField(#member, &type::member)
+
+/**
+ * Declares the decodable fields of a struct.
+ * Must be used in the global namespace.
+ * CONFIGCC_FIELDS(Server, CONFIGCC_FIELD(Server, host), CONFIGCC_FIELD(Server, port))
+ */
+#define CONFIGCC_FIELDS(type, ...) \
+    template<> \
+    struct liblc::ConfigFields<type> { \
+        static auto fields() { \
+            return std::make_tuple(__VA_ARGS__); \
+        } \
+    };
+
+#endif
@@ -30,6 +30,27 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include <sstream>
 #include <iomanip>
 #include <any>
+#include <set>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <charconv>
+#include <functional>
+#include <string_view>
+#include <memory_resource>
+#include <chrono>
+#include <tuple>
+#include <iterator>
 
 #include "lstr.h"
 #include "liblc_typedefs.h"
@@ -69,7 +90,515 @@ namespace liblc {
         MISSING_RIGHT_BRACE,
         EXPECTED_EOF,
         TYPE_ERROR,
-        OUT_OF_BOUNDS
+        OUT_OF_BOUNDS,
+        SCHEMA_TYPE_ERROR,
+        SCHEMA_MISSING_KEY,
+        SCHEMA_UNKNOWN_KEY,
+        SCHEMA_OUT_OF_RANGE,
+        SCHEMA_INVALID_VALUE,
+        EXPECTED_INCLUDE_PATH,
+        INCLUDE_NOT_FOUND,
+        INCLUDE_CYCLE,
+        DEPTH_LIMIT_EXCEEDED,
+        TOKEN_LIMIT_EXCEEDED,
+        STRING_LIMIT_EXCEEDED,
+        NODE_LIMIT_EXCEEDED,
+        INVALID_QUERY
+    };
+
+    /**
+     * Limits for untrusted input, 0 disables a limit.
+     * maxDepth counts nested sections and lists,
+     * maxStringLength applies to strings and identifiers,
+     * maxNodes counts every value including packed list elements.
+     * Depth and values of included documents count towards the including document.
+     */
+    struct ConfigLimits {
+        size_t maxDepth = 0;
+        size_t maxTokens = 0;
+        size_t maxStringLength = 0;
+        size_t maxNodes = 0;
+    };
+
+    struct ConfigStats;
+    typedef std::function<void(const ConfigStats&)> ConfigStatsCallback;
+
+    /**
+     * Statistics of scanning, parsing and stringify.
+     * Values accumulate until reset, pass one instance to the scanner,
+     * parser and stringify of a load to collect all phases.
+     * numberTime and unescapeTime are part of scanTime.
+     * allocations and allocatedBytes count the requests that tokens, nodes and containers
+     * make to the active allocator (the heap, the node pool or a memory resource set by the caller)
+     * while scanning or parsing. Blocks the pool takes from its free lists are requests as well.
+     * Values that std::any or std::string keep on the heap are not counted.
+     */
+    struct ConfigStats {
+        std::chrono::nanoseconds scanTime{0};
+        std::chrono::nanoseconds numberTime{0};
+        std::chrono::nanoseconds unescapeTime{0};
+        std::chrono::nanoseconds parseTime{0};
+        std::chrono::nanoseconds stringifyTime{0};
+        std::chrono::nanoseconds indexTime{0};
+        size_t scannedBytes = 0;
+        size_t stringifiedBytes = 0;
+        // indexes built and elements added to them
+        size_t indexes = 0;
+        size_t indexedEntries = 0;
+        // indexed by TokenType
+        size_t tokens[MINUS+1] = {};
+        // indexed by ObjectType
+        size_t nodes[IGNORE+1] = {};
+        size_t maxDepth = 0;
+        size_t allocations = 0;
+        size_t allocatedBytes = 0;
+        // called after each parse, stringify and index build
+        ConfigStatsCallback callback;
+
+        void report() {
+            if (callback) {
+                callback(*this);
+            }
+        }
+
+        void reset() {
+            auto keep = callback;
+            *this = ConfigStats();
+            callback = keep;
+        }
+    };
+
+    /**
+     * Memory resource owned by shared pointers,
+     * allocations made through ConfigPoolAllocator keep it alive.
+     */
+    class ConfigSharedResource: public std::pmr::memory_resource,
+        public std::enable_shared_from_this<ConfigSharedResource> {
+    };
+
+    /**
+     * Passes allocations to upstream and counts them while a
+     * ConfigStatsTimer is active on the current thread.
+     * owner keeps upstream alive if it is shared.
+     */
+    class ConfigCountingResource: public ConfigSharedResource {
+        public:
+            ConfigCountingResource(std::pmr::memory_resource *upstream=std::pmr::new_delete_resource(),
+                    std::shared_ptr<void> owner=nullptr):
+                upstream(upstream), owner(owner) {}
+
+            /**
+             * Returns:
+             *  a resource that counts heap allocations
+             */
+            static ConfigCountingResource* get() {
+                // never destroyed, documents may be released during exit
+                static ConfigCountingResource *resource = new ConfigCountingResource();
+                return resource;
+            }
+
+            static ConfigStats*& active() {
+                thread_local ConfigStats *stats = nullptr;
+                return stats;
+            }
+
+            std::pmr::memory_resource* getUpstream() const {
+                return upstream;
+            }
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override {
+                auto stats = active();
+                if (stats) {
+                    stats->allocations++;
+                    stats->allocatedBytes += bytes;
+                }
+                return upstream->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void *block, size_t bytes, size_t alignment) override {
+                upstream->deallocate(block, bytes, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+                return this == &other;
+            }
+
+            std::pmr::memory_resource *upstream;
+            std::shared_ptr<void> owner;
+    };
+
+    /**
+     * Adds the lifetime of the timer to a phase of stats.
+     * Does nothing if stats is nullptr.
+     */
+    class ConfigStatsTimer {
+        public:
+            ConfigStatsTimer(ConfigStats *stats, std::chrono::nanoseconds ConfigStats::*phase):
+                stats(stats), phase(phase) {
+                if (stats) {
+                    previous = ConfigCountingResource::active();
+                    ConfigCountingResource::active() = stats;
+                    start = std::chrono::steady_clock::now();
+                }
+            }
+
+            ~ConfigStatsTimer() {
+                if (stats) {
+                    stats->*phase += std::chrono::steady_clock::now() - start;
+                    ConfigCountingResource::active() = previous;
+                }
+            }
+        private:
+            ConfigStats *stats;
+            std::chrono::nanoseconds ConfigStats::*phase;
+            ConfigStats *previous = nullptr;
+            std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * Section key.
+     * Keys created by a ConfigKeyTable share their string so every distinct key
+     * is stored once, equal keys of the same table compare by pointer.
+     */
+    class ConfigKey {
+        public:
+            ConfigKey(const std::string &key):
+                key(std::make_shared<const std::string>(key)) {}
+
+            explicit ConfigKey(const char *key):
+                key(std::make_shared<const std::string>(key)) {}
+
+            ConfigKey(std::shared_ptr<const std::string> interned):
+                key(interned) {}
+
+            const std::string& str() const {
+                return *key;
+            }
+
+            operator const std::string&() const {
+                return *key;
+            }
+
+            bool operator==(const ConfigKey &other) const {
+                return key == other.key || *key == *other.key;
+            }
+
+            bool operator!=(const ConfigKey &other) const {
+                return !(*this == other);
+            }
+
+            /**
+             * Returns:
+             *  true if both keys share the same interned string
+             */
+            bool isSame(const ConfigKey &other) const {
+                return key == other.key;
+            }
+        private:
+            std::shared_ptr<const std::string> key;
+    };
+
+    inline std::ostream& operator<<(std::ostream &stream, const ConfigKey &key) {
+        return stream << key.str();
+    }
+
+    /**
+     * Orders keys by content so sections iterate in sorted order,
+     * allows lookups by std::string without creating a key.
+     * Lookups compare strings whether or not the key is interned.
+     */
+    struct ConfigKeyLess {
+        typedef void is_transparent;
+
+        bool operator()(const ConfigKey &a, const ConfigKey &b) const {
+            return !a.isSame(b) && a.str() < b.str();
+        }
+
+        bool operator()(const ConfigKey &a, const std::string &b) const {
+            return a.str() < b;
+        }
+
+        bool operator()(const std::string &a, const ConfigKey &b) const {
+            return a < b.str();
+        }
+    };
+
+    /**
+     * Stores every distinct key once.
+     * Only tables created as concurrent may be shared between threads,
+     * other tables do not lock.
+     * Keys stay in the table until purge() is called or the table is destroyed,
+     * documents keep their keys alive either way.
+     */
+    class ConfigKeyTable {
+        public:
+            ConfigKeyTable(bool concurrent=true):
+                concurrent(concurrent) {}
+
+            ConfigKey intern(const std::string &key) {
+                std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+                if (concurrent) {
+                    lock.lock();
+                }
+                auto found = keys.find(key);
+                if (found != keys.end()) {
+                    return ConfigKey(found->second);
+                }
+
+                auto interned = std::make_shared<const std::string>(key);
+                keys[std::string_view(*interned)] = interned;
+                return ConfigKey(interned);
+            }
+
+            /**
+             * Removes keys that are not used by any document.
+             * Returns:
+             *  the amount of removed keys
+             */
+            size_t purge() {
+                std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+                if (concurrent) {
+                    lock.lock();
+                }
+                size_t removed = 0;
+                for (auto it = keys.begin(); it != keys.end();) {
+                    if (it->second.use_count() == 1) {
+                        it = keys.erase(it);
+                        removed++;
+                    } else {
+                        ++it;
+                    }
+                }
+                return removed;
+            }
+
+            size_t getSize() {
+                std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+                if (concurrent) {
+                    lock.lock();
+                }
+                return keys.size();
+            }
+
+            bool isConcurrent() const {
+                return concurrent;
+            }
+        private:
+            bool concurrent;
+            std::mutex mutex;
+            std::unordered_map<std::string_view, std::shared_ptr<const std::string>> keys;
+    };
+
+    /**
+     * Keeps freed blocks in a free list per size class of 16 bytes up to 512 bytes,
+     * larger blocks are passed to operator new.
+     * The first thread that allocates owns the pool and uses its free lists without locking,
+     * other threads allocate from the heap and return blocks through a lock free list
+     * that the owner takes over when its own list is empty.
+     * Nodes, shared pointer control blocks and the storage of sections, lists
+     * and packed values are recycled. Values that std::any stores on the heap,
+     * like the pointer to a container or strings that are too long for the small
+     * string buffer, are not.
+     */
+    class ConfigNodePool: public ConfigSharedResource {
+        public:
+            ~ConfigNodePool() {
+                trim();
+            }
+
+            void* allocate(size_t size) {
+                size_t index = sizeClass(size);
+                if (index >= classCount || !isOwner()) {
+                    allocations.fetch_add(1, std::memory_order_relaxed);
+                    return ::operator new(index >= classCount ? size : classSize(index));
+                }
+
+                auto &sizeClass = classes[index];
+                if (!sizeClass.local) {
+                    sizeClass.local = sizeClass.remote.exchange(nullptr, std::memory_order_acquire);
+                }
+                if (sizeClass.local) {
+                    auto block = sizeClass.local;
+                    sizeClass.local = block->next;
+                    return block;
+                }
+                allocations.fetch_add(1, std::memory_order_relaxed);
+                return ::operator new(classSize(index));
+            }
+
+            void deallocate(void *block, size_t size) {
+                size_t index = sizeClass(size);
+                if (index >= classCount) {
+                    ::operator delete(block);
+                    return;
+                }
+
+                auto freed = static_cast<Block*>(block);
+                auto &sizeClass = classes[index];
+                if (isOwner()) {
+                    freed->next = sizeClass.local;
+                    sizeClass.local = freed;
+                    return;
+                }
+
+                // only pushed here, the owner takes the whole list at once
+                freed->next = sizeClass.remote.load(std::memory_order_relaxed);
+                while (!sizeClass.remote.compare_exchange_weak(freed->next, freed,
+                            std::memory_order_release, std::memory_order_relaxed)) {
+                }
+            }
+
+            /**
+             * Returns the free blocks to the heap.
+             * Must be called from the thread that owns the pool.
+             */
+            void trim() {
+                for (auto &sizeClass : classes) {
+                    release(sizeClass.local);
+                    sizeClass.local = nullptr;
+                    release(sizeClass.remote.exchange(nullptr, std::memory_order_acquire));
+                }
+            }
+
+            /**
+             * Returns:
+             *  the number of blocks that had to be allocated
+             */
+            size_t getAllocations() {
+                return allocations.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * Must be called from the thread that owns the pool.
+             */
+            size_t getFreeBlocks() {
+                size_t count = 0;
+                for (auto &sizeClass : classes) {
+                    sizeClass.local = append(sizeClass.local, sizeClass.remote.exchange(nullptr, std::memory_order_acquire));
+                    for (auto block = sizeClass.local; block; block = block->next) {
+                        count++;
+                    }
+                }
+                return count;
+            }
+        protected:
+            void* do_allocate(size_t bytes, size_t alignment) override {
+                if (alignment > alignof(std::max_align_t)) {
+                    throw std::bad_alloc();
+                }
+                return allocate(bytes);
+            }
+
+            void do_deallocate(void *block, size_t bytes, size_t alignment) override {
+                deallocate(block, bytes);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+                return this == &other;
+            }
+        private:
+            struct Block {
+                Block *next;
+            };
+
+            struct SizeClass {
+                // owner thread only
+                Block *local = nullptr;
+                // returned by other threads
+                std::atomic<Block*> remote { nullptr };
+            };
+
+            static const size_t granularity = 16;
+            static const size_t classCount = 32;
+
+            static size_t sizeClass(size_t size) {
+                return size == 0 ? 0 : (size - 1) / granularity;
+            }
+
+            static size_t classSize(size_t index) {
+                return (index + 1) * granularity;
+            }
+
+            bool isOwner() {
+                auto self = std::this_thread::get_id();
+                auto current = owner.load(std::memory_order_relaxed);
+                if (current == std::thread::id()) {
+                    owner.compare_exchange_strong(current, self, std::memory_order_relaxed);
+                    return current == std::thread::id() || current == self;
+                }
+                return current == self;
+            }
+
+            static Block* append(Block *list, Block *other) {
+                if (!list) {
+                    return other;
+                }
+                auto last = list;
+                while (last->next) {
+                    last = last->next;
+                }
+                last->next = other;
+                return list;
+            }
+
+            static void release(Block *list) {
+                while (list) {
+                    auto next = list->next;
+                    ::operator delete(list);
+                    list = next;
+                }
+            }
+
+            std::atomic<std::thread::id> owner { std::thread::id() };
+            std::atomic<size_t> allocations { 0 };
+            SizeClass classes[classCount];
+    };
+
+    /**
+     * Allocator for std::allocate_shared from a node pool or another shared resource.
+     * Every allocation keeps the resource alive.
+     */
+    template<typename T>
+    class ConfigPoolAllocator {
+        public:
+            typedef T value_type;
+
+            ConfigPoolAllocator(std::shared_ptr<ConfigSharedResource> pool):
+                pool(pool) {}
+
+            template<typename U>
+            ConfigPoolAllocator(const ConfigPoolAllocator<U> &other):
+                pool(other.getPool()) {}
+
+            T* allocate(size_t n) {
+                return static_cast<T*>(pool->allocate(n * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(T *block, size_t n) {
+                pool->deallocate(block, n * sizeof(T), alignof(T));
+            }
+
+            // containers allocate their elements from the pool as well
+            template<typename U, typename... Args>
+            void construct(U *object, Args&&... args) {
+                std::pmr::polymorphic_allocator<U>(pool.get()).construct(object, std::forward<Args>(args)...);
+            }
+
+            const std::shared_ptr<ConfigSharedResource>& getPool() const {
+                return pool;
+            }
+
+            template<typename U>
+            bool operator==(const ConfigPoolAllocator<U> &other) const {
+                return pool == other.getPool();
+            }
+
+            template<typename U>
+            bool operator!=(const ConfigPoolAllocator<U> &other) const {
+                return pool != other.getPool();
+            }
+        private:
+            std::shared_ptr<ConfigSharedResource> pool;
     };
 
     class ConfigObject;
@@ -79,9 +608,222 @@ namespace liblc {
     typedef bool ConfigBool;
     typedef std::string ConfigString;
     typedef std::nullptr_t ConfigNil;
-    typedef std::vector<std::shared_ptr<ConfigObject>> ConfigList;
-    typedef std::map<std::string, std::shared_ptr<ConfigObject>> ConfigSection;
+    // containers allocate from the memory resource they were created with
+    typedef std::pmr::vector<std::shared_ptr<ConfigObject>> ConfigList;
+    typedef std::pmr::map<ConfigKey, std::shared_ptr<ConfigObject>, ConfigKeyLess> ConfigSection;
+
+    /**
+     * Storage of packed lists.
+     * elements holds objects for readers that need them, see ConfigObject::toList.
+     */
+    template<typename T>
+    class ConfigPackedArray: public std::pmr::vector<T> {
+        public:
+            using std::pmr::vector<T>::vector;
+
+            mutable std::shared_ptr<ConfigList> elements;
+    };
+    typedef ConfigPackedArray<ConfigNumber> ConfigNumberArray;
+    typedef ConfigPackedArray<ConfigReal> ConfigRealArray;
+
+
+    /**
+     * Non-owning view of contiguous values
+     */
+    template<typename T>
+    class ConfigSpan {
+        public:
+            ConfigSpan(const T *data, size_t count):
+                data(data), count(count) {}
+
+            const T* begin() const {
+                return data;
+            }
+
+            const T* end() const {
+                return data + count;
+            }
+
+            const T& operator[](size_t index) const {
+                return data[index];
+            }
+
+            size_t size() const {
+                return count;
+            }
+
+            const T* getData() const {
+                return data;
+            }
+        private:
+            const T *data;
+            size_t count;
+    };
+
+    /**
+     * Read only view of a list, elements are returned as const objects.
+     * operator-> returns the view itself so it is used like the list pointer
+     * returned by a non-const object.
+     */
+    class ConfigListView {
+        public:
+            class iterator {
+                public:
+                    typedef std::input_iterator_tag iterator_category;
+                    typedef std::shared_ptr<const ConfigObject> value_type;
+                    typedef std::ptrdiff_t difference_type;
+                    typedef const value_type* pointer;
+                    typedef value_type reference;
+
+                    iterator(ConfigList::const_iterator it):
+                        it(it) {}
+
+                    value_type operator*() const {
+                        return *it;
+                    }
+
+                    iterator& operator++() {
+                        ++it;
+                        return *this;
+                    }
+
+                    bool operator==(const iterator &other) const {
+                        return it == other.it;
+                    }
+
+                    bool operator!=(const iterator &other) const {
+                        return it != other.it;
+                    }
+                private:
+                    ConfigList::const_iterator it;
+            };
+
+            ConfigListView(std::shared_ptr<const ConfigList> list):
+                list(list) {}
+
+            std::shared_ptr<const ConfigObject> at(size_t index) const {
+                return list->at(index);
+            }
+
+            std::shared_ptr<const ConfigObject> operator[](size_t index) const {
+                return (*list)[index];
+            }
+
+            size_t size() const {
+                return list->size();
+            }
+
+            bool empty() const {
+                return list->empty();
+            }
+
+            iterator begin() const {
+                return iterator(list->begin());
+            }
+
+            iterator end() const {
+                return iterator(list->end());
+            }
+
+            const ConfigListView* operator->() const {
+                return this;
+            }
+        private:
+            std::shared_ptr<const ConfigList> list;
+    };
+
+    /**
+     * Read only view of a section, values are returned as const objects.
+     * operator-> returns the view itself so it is used like the section pointer
+     * returned by a non-const object.
+     */
+    class ConfigSectionView {
+        public:
+            struct Entry {
+                const ConfigKey &first;
+                std::shared_ptr<const ConfigObject> second;
+            };
+
+            class iterator {
+                public:
+                    typedef std::input_iterator_tag iterator_category;
+                    typedef Entry value_type;
+                    typedef std::ptrdiff_t difference_type;
+                    typedef const Entry* pointer;
+                    typedef Entry reference;
+
+                    // keeps the entry alive for operator->
+                    struct Arrow {
+                        Entry entry;
+
+                        const Entry* operator->() const {
+                            return &entry;
+                        }
+                    };
+
+                    iterator(ConfigSection::const_iterator it):
+                        it(it) {}
+
+                    Entry operator*() const {
+                        return Entry { it->first, it->second };
+                    }
+
+                    Arrow operator->() const {
+                        return Arrow { **this };
+                    }
+
+                    iterator& operator++() {
+                        ++it;
+                        return *this;
+                    }
 
+                    bool operator==(const iterator &other) const {
+                        return it == other.it;
+                    }
+
+                    bool operator!=(const iterator &other) const {
+                        return it != other.it;
+                    }
+                private:
+                    ConfigSection::const_iterator it;
+            };
+
+            ConfigSectionView(std::shared_ptr<const ConfigSection> section):
+                section(section) {}
+
+            // K is a ConfigKey or std::string
+            template<typename K>
+            iterator find(const K &key) const {
+                return iterator(section->find(key));
+            }
+
+            template<typename K>
+            size_t count(const K &key) const {
+                return section->count(key);
+            }
+
+            size_t size() const {
+                return section->size();
+            }
+
+            bool empty() const {
+                return section->empty();
+            }
+
+            iterator begin() const {
+                return iterator(section->begin());
+            }
+
+            iterator end() const {
+                return iterator(section->end());
+            }
+
+            const ConfigSectionView* operator->() const {
+                return this;
+            }
+        private:
+            std::shared_ptr<const ConfigSection> section;
+    };
 
     class Token;
 
@@ -118,6 +860,32 @@ namespace liblc {
                         return "Type error";
                     case OUT_OF_BOUNDS:
                         return "Value out of bounds";
+                    case SCHEMA_TYPE_ERROR:
+                        return "Value does not match schema type";
+                    case SCHEMA_MISSING_KEY:
+                        return "Required key is missing";
+                    case SCHEMA_UNKNOWN_KEY:
+                        return "Key is not part of schema";
+                    case SCHEMA_OUT_OF_RANGE:
+                        return "Value out of schema range";
+                    case SCHEMA_INVALID_VALUE:
+                        return "Value is not allowed by schema";
+                    case EXPECTED_INCLUDE_PATH:
+                        return "Expected include path";
+                    case INCLUDE_NOT_FOUND:
+                        return "Unable to read include";
+                    case INCLUDE_CYCLE:
+                        return "Include cycle";
+                    case DEPTH_LIMIT_EXCEEDED:
+                        return "Nesting too deep";
+                    case TOKEN_LIMIT_EXCEEDED:
+                        return "Too many tokens";
+                    case STRING_LIMIT_EXCEEDED:
+                        return "String too long";
+                    case NODE_LIMIT_EXCEEDED:
+                        return "Too many values";
+                    case INVALID_QUERY:
+                        return "Invalid query";
                 }
                 return "";
             }
@@ -138,6 +906,12 @@ namespace liblc {
                 ConfigparseCommonException::ConfigparseCommonException(token, error) {}
     };
 
+    class ConfigccLimitError: public ConfigparseCommonException {
+        public:
+            ConfigccLimitError(std::shared_ptr<Token> token, ErrorType error):
+                ConfigparseCommonException::ConfigparseCommonException(token, error) {}
+    };
+
     class ConfigccTypeError: public ConfigparseCommonException {
         public:
             ConfigccTypeError(ObjectType expected):
@@ -146,6 +920,15 @@ namespace liblc {
             const ObjectType expected;
     };
 
+    class ConfigccSchemaError: public ConfigparseCommonException {
+        public:
+            ConfigccSchemaError(std::shared_ptr<Token> token, ErrorType error, std::string detail=""):
+                ConfigparseCommonException::ConfigparseCommonException(token, error), detail(detail) {}
+
+            // offending key if available
+            const std::string detail;
+    };
+
     class ConfigccOutOfBounds: public ConfigparseCommonException {
         public:
             ConfigccOutOfBounds():
@@ -193,17 +976,82 @@ namespace liblc {
     };
 
     /**
-     * Generic object using std::any
+     * Receives events while a document is parsed by ConfigEventParser.
+     * Returning false from onSectionStart or onListStart skips
+     * all events of that subtree including the matching end event.
      */
-    class ConfigObject {
+    class ConfigEventHandler {
         public:
-            ConfigObject(ObjectType type, std::any value):
-                type(type), value(value) {}
+            ConfigEventHandler() {}
+            virtual ~ConfigEventHandler() {}
+
+            virtual bool onSectionStart() {
+                return true;
+            }
+
+            virtual void onSectionEnd() {}
+
+            virtual void onKey(const std::string &key) {}
+
+            virtual bool onListStart() {
+                return true;
+            }
+
+            virtual void onListEnd() {}
+
+            virtual void onNumber(ConfigNumber value) {}
+
+            virtual void onReal(ConfigReal value) {}
+
+            virtual void onString(const std::string &value) {}
+
+            virtual void onBool(ConfigBool value) {}
+
+            virtual void onNil() {}
+    };
+
+    /**
+     * Generic object using std::any
+     */
+    class ConfigObject {
+        public:
+            ConfigObject(ObjectType type, std::any value):
+                type(type), value(value) {}
+
+            // packed list of numbers
+            ConfigObject(std::shared_ptr<ConfigNumberArray> numbers):
+                type(LIST), packedType(NUMBER), value(numbers) {}
+
+            // packed list of reals
+            ConfigObject(std::shared_ptr<ConfigRealArray> reals):
+                type(LIST), packedType(REAL), value(reals) {}
 
             // copy constructor
             ConfigObject(ConfigObject *original) {
                 type = original->type;
                 value = original->value;
+                packedType = original->packedType;
+            }
+
+            ConfigObject(const ConfigObject&) = default;
+            ConfigObject(ConfigObject&&) = default;
+            ConfigObject& operator=(const ConfigObject&) = default;
+            ConfigObject& operator=(ConfigObject&&) = default;
+
+            /**
+             * Children that are only owned by this object are released with an explicit stack
+             * so the native stack does not grow with the nesting depth.
+             */
+            ~ConfigObject() {
+                std::vector<std::shared_ptr<ConfigObject>> pending;
+                detachChildren(pending);
+                while (!pending.empty()) {
+                    auto child = std::move(pending.back());
+                    pending.pop_back();
+                    if (child.use_count() == 1) {
+                        child->detachChildren(pending);
+                    }
+                }
             }
 
             template<typename T>
@@ -211,14 +1059,19 @@ namespace liblc {
                 return std::any_cast<T>(value);
             }
 
-            ConfigReal toReal() {
+            template<typename T>
+            T castTo() const {
+                return std::any_cast<T>(value);
+            }
+
+            ConfigReal toReal() const {
                 if (isNumber()) {
                     return castTo<ConfigNumber>();
                 }
                 return castTo<ConfigReal>();
             }
 
-            ConfigNumber toNumber() {
+            ConfigNumber toNumber() const {
                 if (isReal()) {
                     return castTo<ConfigReal>();
                 }
@@ -229,55 +1082,145 @@ namespace liblc {
                 return castTo<ConfigString&>();
             }
 
-            ConfigBool toBool()  {
+            const ConfigString& toString() const {
+                return castTo<const ConfigString&>();
+            }
+
+            ConfigBool toBool() const {
                 return castTo<ConfigBool>();
             }
 
-            ConfigNil toNil() {
+            ConfigNil toNil() const {
                 return castTo<ConfigNil>();
             }
 
+            /**
+             * Packed lists are unpacked first so changes to the returned list are kept.
+             * This modifies the object and must not race with readers.
+             */
             std::shared_ptr<ConfigList> toList() {
+                unpack();
                 return castTo<std::shared_ptr<ConfigList>>();
             }
 
+            /**
+             * Elements of a const list are const as well.
+             * Reading never changes a packed list, its elements are returned
+             * as a list of objects that is built once and shared by all readers.
+             */
+            ConfigListView toList() const {
+                if (isPacked()) {
+                    return ConfigListView(elements());
+                }
+                return ConfigListView(castTo<std::shared_ptr<ConfigList>>());
+            }
+
+            /**
+             * Converts a packed list to a ConfigList of objects in place.
+             * This modifies the object and must not race with readers.
+             */
+            void unpack() {
+                if (!isPacked()) {
+                    return;
+                }
+                // the shared element list may still be read through copies
+                value = unpacked();
+                packedType = NIL;
+            }
+
+            /**
+             * Returns:
+             *  the contiguous values of a packed NUMBER list
+             */
+            ConfigSpan<ConfigNumber> toNumberSpan() const {
+                return toSpan<ConfigNumber>(NUMBER);
+            }
+
+            /**
+             * Returns:
+             *  the contiguous values of a packed REAL list
+             */
+            ConfigSpan<ConfigReal> toRealSpan() const {
+                return toSpan<ConfigReal>(REAL);
+            }
+
+            /**
+             * Returns:
+             *  true if this is a list stored as contiguous numbers
+             */
+            bool isPacked() const {
+                return packedType != NIL;
+            }
+
+            /**
+             * Returns:
+             *  NUMBER or REAL for packed lists, NIL otherwise
+             */
+            ObjectType getPackedType() const {
+                return packedType;
+            }
+
+            /**
+             * Returns:
+             *  the amount of items in a list or section
+             */
+            size_t getSize() const {
+                if (packedType == NUMBER) {
+                    return castTo<std::shared_ptr<ConfigNumberArray>>()->size();
+                } else if (packedType == REAL) {
+                    return castTo<std::shared_ptr<ConfigRealArray>>()->size();
+                } else if (isList()) {
+                    return toList()->size();
+                } else if (isSection()) {
+                    return toSection()->size();
+                }
+                throw ConfigccTypeError(LIST);
+            }
+
             std::shared_ptr<ConfigSection> toSection() {
                 return castTo<std::shared_ptr<ConfigSection>>();
             }
 
-            ObjectType getType() {
+            /**
+             * Values of a const section are const as well.
+             */
+            ConfigSectionView toSection() const {
+                return ConfigSectionView(castTo<std::shared_ptr<ConfigSection>>());
+            }
+
+            ObjectType getType() const {
                 return type;
             }
 
-            bool isNumber() {
+            bool isNumber() const {
                 return type == NUMBER;
             }
 
-            bool isReal() {
+            bool isReal() const {
                 return type == REAL;
             }
 
-            bool isBool() {
+            bool isBool() const {
                 return type == BOOLEAN;
             }
 
-            bool isNil() {
+            bool isNil() const {
                 return type == NIL;
             }
 
-            bool isString() {
+            bool isString() const {
                 return type == STRING;
             }
 
-            bool isList() {
+            bool isList() const {
                 return type == LIST;
             }
 
-            bool isScalar() {
+            bool isScalar() const {
                 return type == NUMBER || type == REAL;
             }
 
-            bool isSection() {
+            bool isSection() const {
                 return type == SECTION;
             }
 
@@ -313,7 +1256,12 @@ namespace liblc {
             }
 
             std::shared_ptr<ConfigObject> get(size_t index) {
-                if (isList()) {
+                if (isPacked()) {
+                    if (index >= getSize()) {
+                        throw ConfigccOutOfBounds();
+                    }
+                    return elements()->at(index);
+                } else if (isList()) {
                     if (index >= toList()->size()) {
                         throw ConfigccOutOfBounds();
                     }
@@ -322,7 +1270,18 @@ namespace liblc {
                 throw ConfigccTypeError(LIST);
             }
 
-            std::shared_ptr<ConfigObject> get(std::string name) {
+            std::shared_ptr<ConfigObject> get(const ConfigKey &key) {
+                if (isSection()) {
+                    auto found = toSection()->find(key);
+                    if (found == toSection()->end()) {
+                        throw ConfigccKeyNotFound();
+                    }
+                    return found->second;
+                }
+                throw ConfigccTypeError(SECTION);
+            }
+
+            std::shared_ptr<ConfigObject> get(const std::string &name) {
                 if (isSection()) {
                     auto found = toSection()->find(name);
                     if (found == toSection()->end()) {
@@ -332,28 +1291,269 @@ namespace liblc {
                 }
                 throw ConfigccTypeError(SECTION);
             }
+
+            std::shared_ptr<const ConfigObject> get(size_t index) const {
+                if (isPacked()) {
+                    if (index >= getSize()) {
+                        throw ConfigccOutOfBounds();
+                    }
+                    return elements()->at(index);
+                } else if (isList()) {
+                    auto list = toList();
+                    if (index >= list->size()) {
+                        throw ConfigccOutOfBounds();
+                    }
+                    return list->at(index);
+                }
+                throw ConfigccTypeError(LIST);
+            }
+
+            std::shared_ptr<const ConfigObject> get(const ConfigKey &key) const {
+                return getConst(key);
+            }
+
+            std::shared_ptr<const ConfigObject> get(const std::string &name) const {
+                return getConst(name);
+            }
         private:
+            /**
+             * Moves the containers in a container that nobody else references to pending,
+             * scalars are released right away.
+             */
+            void detachChildren(std::vector<std::shared_ptr<ConfigObject>> &pending) {
+                if (type == LIST && !isPacked()) {
+                    auto list = std::any_cast<std::shared_ptr<ConfigList>>(&value);
+                    if (list && list->use_count() == 1) {
+                        for (auto &child : **list) {
+                            if (child && (child->isSection() || child->isList())) {
+                                pending.push_back(std::move(child));
+                            }
+                        }
+                        (*list)->clear();
+                    }
+                } else if (type == SECTION) {
+                    auto section = std::any_cast<std::shared_ptr<ConfigSection>>(&value);
+                    if (section && section->use_count() == 1) {
+                        for (auto &entry : **section) {
+                            if (entry.second && (entry.second->isSection() || entry.second->isList())) {
+                                pending.push_back(std::move(entry.second));
+                            }
+                        }
+                        (*section)->clear();
+                    }
+                }
+            }
+
+            template<typename K>
+            std::shared_ptr<const ConfigObject> getConst(const K &key) const {
+                if (isSection()) {
+                    auto section = toSection();
+                    auto found = section->find(key);
+                    if (found == section->end()) {
+                        throw ConfigccKeyNotFound();
+                    }
+                    return found->second;
+                }
+                throw ConfigccTypeError(SECTION);
+            }
+
+            template<typename T>
+            ConfigSpan<T> toSpan(ObjectType expected) const {
+                if (packedType != expected) {
+                    throw ConfigccTypeError(expected);
+                }
+                auto values = castTo<std::shared_ptr<ConfigPackedArray<T>>>();
+                return ConfigSpan<T>(values->data(), values->size());
+            }
+
+            /**
+             * The first reader builds the element list, concurrent readers
+             * may build it too but all of them keep the first one published.
+             */
+            std::shared_ptr<ConfigList> elements() const {
+                std::shared_ptr<ConfigList> *cached = packedType == NUMBER
+                    ? &castTo<std::shared_ptr<ConfigNumberArray>>()->elements
+                    : &castTo<std::shared_ptr<ConfigRealArray>>()->elements;
+                auto list = std::atomic_load(cached);
+                if (list) {
+                    return list;
+                }
+                auto built = unpacked();
+                if (std::atomic_compare_exchange_strong(cached, &list, built)) {
+                    return built;
+                }
+                return list;
+            }
+
+            /**
+             * Objects are allocated from the resource of the packed values.
+             */
+            std::shared_ptr<ConfigList> unpacked() const {
+                auto resource = packedType == NUMBER
+                        ? castTo<std::shared_ptr<ConfigNumberArray>>()->get_allocator().resource()
+                        : castTo<std::shared_ptr<ConfigRealArray>>()->get_allocator().resource();
+                auto shared = dynamic_cast<ConfigSharedResource*>(resource);
+                if (auto owner = shared ? shared->weak_from_this().lock() : nullptr) {
+                    // elements may outlive the list, they keep the pool alive
+                    return unpacked(ConfigPoolAllocator<ConfigObject>(owner));
+                }
+                return unpacked(std::pmr::polymorphic_allocator<ConfigObject>(resource));
+            }
+
+            template<typename A>
+            std::shared_ptr<ConfigList> unpacked(A allocator) const {
+                auto list = std::allocate_shared<ConfigList>(allocator);
+                list->reserve(getSize());
+                if (packedType == NUMBER) {
+                    for (auto number : toNumberSpan()) {
+                        list->push_back(std::allocate_shared<ConfigObject>(allocator, NUMBER, number));
+                    }
+                } else {
+                    for (auto real : toRealSpan()) {
+                        list->push_back(std::allocate_shared<ConfigObject>(allocator, REAL, real));
+                    }
+                }
+                return list;
+            }
+
+            // both types share the slot in front of value
             ObjectType type;
+            ObjectType packedType = NIL;
             std::any value;
     };
 
+    /**
+     * Text and path of a document shared by all of its tokens.
+     * A source may be a fragment of a larger stream that begins at firstOffset
+     * on firstLine and firstColumn.
+     * Lines and columns are not tracked while scanning, the first lookup
+     * builds an index of the line starts which is then searched.
+     */
+    class ConfigSource {
+        public:
+            ConfigSource(std::string text, std::string path="",
+                    unsigned int firstLine=1, unsigned int firstOffset=0, unsigned int firstColumn=1):
+                text(text), path(path), firstLine(firstLine), firstOffset(firstOffset), firstColumn(firstColumn) {}
+
+            const std::string& getText() const {
+                return text;
+            }
+
+            const std::string& getPath() const {
+                return path;
+            }
+
+            unsigned int getFirstOffset() const {
+                return firstOffset;
+            }
+
+            /**
+             * Returns the text between offset and offset+length.
+             */
+            std::string_view getText(unsigned int offset, unsigned int length) const {
+                return std::string_view(text).substr(offset - firstOffset, length);
+            }
+
+            /**
+             * Returns:
+             *  the 1 based line of offset
+             */
+            unsigned int getLine(unsigned int offset) const {
+                return firstLine + lineIndex(offset);
+            }
+
+            /**
+             * Returns:
+             *  the 1 based column of offset
+             */
+            unsigned int getColumn(unsigned int offset) const {
+                auto index = lineIndex(offset);
+                return offset - firstOffset - lineStarts[index] + (index == 0 ? firstColumn : 1);
+            }
+
+            /**
+             * Replaces the text, this must not be called while tokens still refer
+             * to the source.
+             */
+            void assign(const std::string &text, const std::string &path,
+                    unsigned int firstLine=1, unsigned int firstOffset=0, unsigned int firstColumn=1) {
+                this->text.assign(text);
+                this->path = path;
+                this->firstLine = firstLine;
+                this->firstOffset = firstOffset;
+                this->firstColumn = firstColumn;
+                lineStarts.clear();
+                indexed = false;
+            }
+
+        private:
+            size_t lineIndex(unsigned int offset) const {
+                buildIndex();
+                auto found = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset - firstOffset);
+                return found - lineStarts.begin() - 1;
+            }
+
+            void buildIndex() const {
+                if (indexed.load(std::memory_order_acquire)) {
+                    return;
+                }
+                std::lock_guard<std::mutex> guard(indexLock);
+                if (indexed.load(std::memory_order_relaxed)) {
+                    return;
+                }
+
+                // memchr is vectorized by the c library
+                lineStarts.push_back(0);
+                const char *begin = text.data();
+                const char *end = begin + text.size();
+                for (auto c = begin; (c = (const char*)memchr(c, '\n', end - c)); c++) {
+                    lineStarts.push_back(c - begin + 1);
+                }
+                indexed.store(true, std::memory_order_release);
+            }
+
+            std::string text;
+            std::string path;
+            unsigned int firstLine;
+            unsigned int firstOffset;
+            unsigned int firstColumn;
+
+            mutable std::vector<unsigned int> lineStarts;
+            mutable std::atomic<bool> indexed = false;
+            mutable std::mutex indexLock;
+    };
+
     class Token {
         public:
-            Token(TokenType type, std::string lexeme, ConfigObject literal, unsigned int line,
-                    std::string path, unsigned int tokenStart, std::shared_ptr<std::string> source):
-                lexeme(lexeme), line(line), type(type), path(path), literal(literal), tokenStart(tokenStart),
-                source(source) {}
+            /**
+             * A token only stores its location in source,
+             * the lexeme, line and column are looked up on demand.
+             */
+            Token(TokenType type, ConfigObject literal, std::shared_ptr<ConfigSource> source,
+                    unsigned int tokenStart, unsigned int length):
+                type(type), tokenStart(tokenStart), length(length), literal(literal), source(source) {}
 
             const std::string getLexeme() {
-                return lexeme;
+                return std::string(getLexemeView());
+            }
+
+            /**
+             * The view is valid as long as the token is.
+             */
+            std::string_view getLexemeView() {
+                return source->getText(tokenStart, length);
             }
 
             const unsigned int getLine() {
-                return line;
+                return source->getLine(tokenStart);
+            }
+
+            const unsigned int getColumn() {
+                return source->getColumn(tokenStart);
             }
 
             const std::string getPath() {
-                return path;
+                return source->getPath();
             }
 
             ConfigObject getLiteral() {
@@ -364,7 +1564,11 @@ namespace liblc {
                 return tokenStart;
             }
 
-            const std::shared_ptr<std::string> getSource() {
+            const unsigned int getLength() {
+                return length;
+            }
+
+            const std::shared_ptr<ConfigSource> getSource() {
                 return source;
             }
 
@@ -373,21 +1577,42 @@ namespace liblc {
             }
 
         private:
-            const std::string lexeme;
-            const unsigned int line;
-            const TokenType type;
-            const std::string path;
+            TokenType type;
+            unsigned int tokenStart;
+            unsigned int length;
             ConfigObject literal;
-            const unsigned int tokenStart;
-            const std::shared_ptr<std::string> source;
+            std::shared_ptr<ConfigSource> source;
     };
 
     class ConfigScanner {
         public:
-            ConfigScanner(std::string source, std::string path=""):
-                source(std::make_shared<std::string>(source)), path(path) { }
+            ConfigScanner(std::string source, std::string path="", ConfigLimits limits=ConfigLimits()):
+                source(std::make_shared<ConfigSource>(source, path)), limits(limits) { }
+
+            /**
+             * Collects statistics in stats, nullptr disables them.
+             */
+            void setStats(ConfigStats *stats) {
+                this->stats = stats;
+            }
+
+            void setLimits(ConfigLimits limits) {
+                this->limits = limits;
+            }
+
+            /**
+             * Tokens are allocated from resource.
+             * The resource has to outlive every token including those of errors.
+             */
+            void setMemoryResource(std::pmr::memory_resource *resource) {
+                this->resource = resource;
+            }
 
-            std::vector<std::shared_ptr<Token>> scanTokens() {
+            const std::vector<std::shared_ptr<Token>>& scanTokens() {
+                ConfigStatsTimer timer(stats, &ConfigStats::scanTime);
+                if (stats) {
+                    stats->scannedBytes += text().size() - current;
+                }
                 while (!isAtEnd()) {
                     start = current;
                     scanToken();
@@ -396,6 +1621,58 @@ namespace liblc {
                 return tokens;
             }
 
+            /**
+             * Scans a single token.
+             * Only the current token is kept in memory.
+             * Returns:
+             *  the next token or EOF_T at the end of the source
+             */
+            std::shared_ptr<Token> nextToken() {
+                tokens.clear();
+                while (tokens.empty() && !isAtEnd()) {
+                    start = current;
+                    scanToken();
+                }
+
+                if (tokens.empty()) {
+                    start = current;
+                    addToken(EOF_T);
+                }
+                return tokens.back();
+            }
+
+            /**
+             * Scans data next, the token buffer and every Token that is
+             * no longer referenced elsewhere are reused.
+             * The source buffer is reused unless a token or error still points to it.
+             */
+            void reset(const std::string &data, const std::string &path="") {
+                spare.insert(spare.end(), tokens.begin(), tokens.end());
+                tokens.clear();
+                spare.erase(std::remove_if(spare.begin(), spare.end(),
+                            [](const std::shared_ptr<Token> &token) { return token.use_count() > 1; }), spare.end());
+
+                long owners = 1;
+                for (auto &token : spare) {
+                    if (token->getSource().get() == source.get()) {
+                        owners++;
+                    }
+                }
+
+                if (source.use_count() == owners) {
+                    source->assign(data, path);
+                } else {
+                    source = std::make_shared<ConfigSource>(data, path);
+                }
+                start = 0;
+                current = 0;
+                scanned = 0;
+            }
+
+            std::vector<std::shared_ptr<Token>>& getTokens() {
+                return tokens;
+            }
+
             bool isDigit(char c) {
                 return c >= '0' && c <= '9';
             }
@@ -457,13 +1734,11 @@ namespace liblc {
                     case '-':
                         addToken(MINUS);
                         break;
-                    // ignore space \t and \r
+                    // ignore whitespace, lines are looked up from the source
                     case ' ':
                     case '\t':
                     case '\r':
-                        break;
                     case '\n':
-                        line++;
                         break;
                     case '\'':
                     case '"':
@@ -485,25 +1760,29 @@ namespace liblc {
 
             char advance() {
                 current++;
-                return source->at(current-1);
+                return text()[current-1];
             }
 
             bool isAtEnd() {
-                return current >= source->size();
+                return current >= text().size();
+            }
+
+            const std::string& text() {
+                return source->getText();
             }
 
             char peek() {
                 if (isAtEnd()) {
                     return '\0';
                 }
-                return source->at(current);
+                return text()[current];
             }
 
             char peekNext() {
-                if (current+1 >= source->size()) {
+                if (current+1 >= text().size()) {
                     return '\0';
                 }
-                return source->at(current+1);
+                return text()[current+1];
             }
 
             void addToken(TokenType type) {
@@ -511,13 +1790,57 @@ namespace liblc {
             }
 
             void addToken(TokenType type, ConfigObject literal) {
-                std::string text = source->substr(start, current-start);
-                tokens.push_back(std::make_shared<Token>(Token(type, text, literal, line, path, start, source)));
+                if (type != EOF_T && limits.maxTokens && ++scanned > limits.maxTokens) {
+                    limitError(TOKEN_LIMIT_EXCEEDED);
+                }
+                if (stats) {
+                    stats->tokens[type]++;
+                }
+                if (!spare.empty()) {
+                    auto token = spare.back();
+                    spare.pop_back();
+                    *token = Token(type, literal, source, start, current-start);
+                    tokens.push_back(token);
+                    return;
+                }
+                if (stats && resource) {
+                    tokens.push_back(std::allocate_shared<Token>(ConfigPoolAllocator<Token>(counting()),
+                                type, literal, source, start, current-start));
+                    return;
+                } else if (resource || stats) {
+                    auto allocator = std::pmr::polymorphic_allocator<Token>(resource ? resource : ConfigCountingResource::get());
+                    tokens.push_back(std::allocate_shared<Token>(allocator,
+                                type, literal, source, start, current-start));
+                    return;
+                }
+                tokens.push_back(std::make_shared<Token>(type, literal, source, start, current-start));
+            }
+
+            /**
+             * Returns:
+             *  a resource that counts the allocations of the memory resource
+             */
+            std::shared_ptr<ConfigCountingResource> counting() {
+                if (!countingResource || countingResource->getUpstream() != resource) {
+                    countingResource = std::make_shared<ConfigCountingResource>(resource);
+                }
+                return countingResource;
+            }
+
+            void checkLength(size_t length) {
+                if (limits.maxStringLength && length > limits.maxStringLength) {
+                    limitError(STRING_LIMIT_EXCEEDED);
+                }
+            }
+
+            void limitError(ErrorType error) {
+                addToken(EOF_T);
+                throw ConfigccLimitError(tokens[tokens.size()-1], error);
             }
 
             bool match(char expected) {
                 if (isAtEnd()
-                        || source->at(current) != expected) {
+                        || text()[current] != expected) {
                     return false;
                 }
                 current++;
@@ -562,16 +1885,16 @@ namespace liblc {
                 try {
                     std::any value;
                     if (isFloat) {
-                        auto number = source->substr(start, current-start);
+                        auto number = text().substr(start, current-start);
                         value = std::any(stringToReal(number));
                     } else if (isBin) {
-                        auto number = source->substr(start+2, current-start);
+                        auto number = text().substr(start+2, current-start);
                         value = std::any(stringToNumber(number, 2));
                     } else if (isHex) {
-                        auto number = source->substr(start, current-start);
+                        auto number = text().substr(start, current-start);
                         value = std::any(stringToNumber(number, 16));
                     } else {
-                        auto number = source->substr(start, current-start);
+                        auto number = text().substr(start, current-start);
                         value = std::any(stringToNumber(number));
                     }
                     addToken(type, ConfigObject(objType, value));
@@ -586,7 +1909,8 @@ namespace liblc {
                     advance();
                 }
 
-                std::string text = source->substr(start, current-start);
+                checkLength(current-start);
+                auto text = std::string_view(this->text()).substr(start, current-start);
 
                 TokenType type = SECTION_NAME;
                 // speicial identifiers
@@ -603,10 +1927,6 @@ namespace liblc {
 
             void scanString(char quote) {
                 while (peek() != quote && !isAtEnd()) {
-                    if (peek() == '\n') {
-                        line++;
-                    }
-
                     // escape character
                     if (peek() == '\\') {
                         advance();
@@ -621,41 +1941,151 @@ namespace liblc {
 
                 // closing "
                 advance();
+                checkLength(current-start-2);
 
-                std::string value = unescape(source->substr(start+1, current-start-2));
+                std::string value = unescapeString(text().substr(start+1, current-start-2));
                 addToken(STRING_TOKEN, ConfigObject(STRING, value));
             }
 
+            std::string unescapeString(const std::string &value) {
+                ConfigStatsTimer timer(stats, &ConfigStats::unescapeTime);
+                return unescape(value);
+            }
+
             ConfigReal stringToReal(const std::string& number) {
+                ConfigStatsTimer timer(stats, &ConfigStats::numberTime);
                 return std::stod(number);
             }
 
             ConfigNumber stringToNumber(const std::string& number, int base=10) {
+                ConfigStatsTimer timer(stats, &ConfigStats::numberTime);
                 return std::stol(number, nullptr, base);
             }
 
-            const std::shared_ptr<std::string> source;
-            const std::string path;
-            unsigned int line = 1;
+            std::shared_ptr<ConfigSource> source;
             unsigned int start = 0;
             unsigned int current = 0;
+            ConfigLimits limits;
+            size_t scanned = 0;
+            std::pmr::memory_resource *resource = nullptr;
+            std::shared_ptr<ConfigCountingResource> countingResource;
+            ConfigStats *stats = nullptr;
 
             std::vector<std::shared_ptr<Token>> tokens;
+            // tokens of the previous scan that can be reused
+            std::vector<std::shared_ptr<Token>> spare;
     };
 
     // interface for generic stringify operation on config objects
     // this is the minimal implementation
     class ConfigStringify: public ConfigObjectVisitor {
         public:
-            ConfigStringify() {}
+            ConfigStringify(ConfigLimits limits=ConfigLimits()):
+                limits(limits) {}
             ~ConfigStringify() {}
 
             virtual std::string stringify(std::shared_ptr<ConfigObject> root) {
-                std::stringstream stream;
-                stream << std::any_cast<std::string>(root->accept(this));
-                return stream.str();
+                std::string result;
+                {
+                    ConfigStatsTimer timer(stats, &ConfigStats::stringifyTime);
+                    std::stringstream stream;
+                    write(stream, root.get());
+                    result = stream.str();
+                }
+
+                if (stats) {
+                    stats->stringifiedBytes += result.size();
+                    stats->report();
+                }
+                return result;
+            }
+
+            /**
+             * Collects statistics in stats, nullptr disables them.
+             */
+            void setStats(ConfigStats *stats) {
+                this->stats = stats;
             }
         private:
+            // open section or list
+            struct Frame {
+                std::shared_ptr<ConfigList> list;
+                size_t index = 0;
+                std::shared_ptr<ConfigSection> section;
+                ConfigSection::iterator it;
+            };
+
+            /**
+             * Writes root using an explicit stack.
+             * The depth and value limits also stop at reference cycles.
+             */
+            void write(std::stringstream &stream, ConfigObject *root) {
+                std::vector<Frame> stack;
+                size_t nodes = 0;
+                ConfigObject *next = root;
+                while (next || !stack.empty()) {
+                    if (next) {
+                        if (limits.maxNodes && ++nodes > limits.maxNodes) {
+                            throw ConfigccLimitError(std::shared_ptr<Token>(nullptr), NODE_LIMIT_EXCEEDED);
+                        }
+
+                        bool container = next->isSection() || (next->isList() && !next->isPacked());
+                        if (container && limits.maxDepth && stack.size() >= limits.maxDepth) {
+                            throw ConfigccLimitError(std::shared_ptr<Token>(nullptr), DEPTH_LIMIT_EXCEEDED);
+                        }
+
+                        Frame frame;
+                        if (next->isSection()) {
+                            stream << '{';
+                            frame.section = next->toSection();
+                            frame.it = frame.section->begin();
+                            stack.push_back(frame);
+                        } else if (container) {
+                            stream << '[';
+                            frame.list = next->toList();
+                            stack.push_back(frame);
+                        } else if (next->isList()) {
+                            stream << '[';
+                            if (next->getPackedType() == NUMBER) {
+                                writePacked(stream, next->toNumberSpan());
+                            } else {
+                                writePacked(stream, next->toRealSpan());
+                            }
+                            stream << ']';
+                        } else {
+                            stream << std::any_cast<std::string>(next->accept(this));
+                        }
+                        next = nullptr;
+                        continue;
+                    }
+
+                    auto &frame = stack.back();
+                    if (frame.section.get()) {
+                        if (frame.it == frame.section->end()) {
+                            stream << '}';
+                            stack.pop_back();
+                            continue;
+                        }
+                        if (frame.it != frame.section->begin()) {
+                            stream << ", ";
+                        }
+                        stream << '"' << frame.it->first << '"' << '=';
+                        next = frame.it->second.get();
+                        frame.it++;
+                    } else {
+                        if (frame.index == frame.list->size()) {
+                            stream << ']';
+                            stack.pop_back();
+                            continue;
+                        }
+                        if (frame.index != 0) {
+                            stream << ", ";
+                        }
+                        next = frame.list->at(frame.index++).get();
+                    }
+                }
+            }
+
             virtual std::any visitNumber(ConfigObject *obj) {
                 std::stringstream stream;
                 stream << obj->toNumber();
@@ -688,223 +2118,2589 @@ namespace liblc {
 
             virtual std::any visitList(ConfigObject *obj) {
                 std::stringstream stream;
-                stream << '[';
-                auto objList = obj->toList();
-                for (auto it = objList->begin(); it != objList->end(); it++) {
-                    if (it != objList->begin()) {
-                        stream << ", ";
-                    }
-                    stream << stringify(*it);
-                }
-                stream << ']';
+                write(stream, obj);
                 return stream.str();
             }
 
             virtual std::any visitSection(ConfigObject *obj) {
                 std::stringstream stream;
-                stream << '{';
-                auto objMap = obj->toSection();
-                for (auto it = objMap->begin(); it != objMap->end(); it++) {
-                    if (it != objMap->begin()) {
+                write(stream, obj);
+                return stream.str();
+            }
+
+            template<typename T>
+            void writePacked(std::stringstream &stream, ConfigSpan<T> values) {
+                for (size_t i = 0; i < values.size(); i++) {
+                    if (i != 0) {
                         stream << ", ";
                     }
-                    stream << '"' << it->first << '"' << '=';
-                    stream << stringify(it->second);
+                    stream << values[i];
                 }
-                stream << '}';
-                return stream.str();
             }
 
+            ConfigLimits limits;
+            ConfigStats *stats = nullptr;
     };
 
-    class ConfigParser {
+    class ConfigWriterError: public std::exception {
         public:
-            ConfigParser(std::vector<std::shared_ptr<Token>> tokens):
-                tokens(tokens) {}
+            ConfigWriterError(std::string text): text(text) {}
+            virtual const char* what() const throw() {
+                return text.c_str();
+            }
+        private:
+            std::string text;
+    };
 
-            ConfigParser(std::string data) {
-                ConfigScanner scanner(data);
-                tokens = scanner.scanTokens();
+    /**
+     * Writes a document without building a tree.
+     * Output is collected in a buffer of bufferSize bytes and written to
+     * the stream or file descriptor whenever it is full.
+     * Memory only depends on bufferSize and nesting depth.
+     * Output uses the same format as ConfigStringify with escaped strings.
+     */
+    class ConfigWriter {
+        public:
+            ConfigWriter(std::ostream &out, size_t bufferSize=64*1024):
+                stream(&out), bufferSize(bufferSize) {
+                buffer.reserve(bufferSize);
             }
 
-            std::shared_ptr<ConfigObject> parse() {
-                if (isAtEnd()) {
-                    // are we at the end already? if so return an empty object
-                    return std::make_shared<ConfigObject>(SECTION, std::make_shared<ConfigSection>(ConfigSection()));
-                }
+            ConfigWriter(int fd, size_t bufferSize=64*1024):
+                fd(fd), bufferSize(bufferSize) {
+                buffer.reserve(bufferSize);
+            }
 
-                // root-level object
-                auto root = object();
-                if (!isAtEnd()) {
-                    throw handleError(EXPECTED_EOF);
+            ~ConfigWriter() {
+                try {
+                    flush();
+                } catch (ConfigWriterError &e) {
+                    // destructors must not throw
                 }
+            }
 
-                return root;
+            void beginSection() {
+                beginValue();
+                buffer += '{';
+                stack.push_back(Level { SECTION, true, false });
             }
 
-        private:
-            std::shared_ptr<ConfigObject> object() {
-                if (check(LEFT_BRACE)) {
-                    return section();
+            void endSection() {
+                endContainer(SECTION);
+                buffer += '}';
+                maybeFlush();
+            }
+
+            void beginList() {
+                beginValue();
+                buffer += '[';
+                stack.push_back(Level { LIST, true, false });
+            }
+
+            void endList() {
+                endContainer(LIST);
+                buffer += ']';
+                maybeFlush();
+            }
+
+            void key(const std::string &name) {
+                if (stack.empty() || stack.back().type != SECTION || stack.back().hasKey) {
+                    throw ConfigWriterError("Key is only valid inside a section");
+                }
+                separator();
+                buffer += '"';
+                escape(name, buffer);
+                buffer += "\"=";
+                stack.back().hasKey = true;
+            }
+
+            void value(ConfigNumber number) {
+                beginValue();
+                char text[16];
+                auto result = std::to_chars(text, text + sizeof(text), number);
+                buffer.append(text, result.ptr - text);
+                maybeFlush();
+            }
+
+            /**
+             * Reals are written in the shortest form that parses back to the same value,
+             * always with a fraction so they are not read as numbers.
+             * The grammar has no exponent, nan or inf, non-finite reals are an error.
+             */
+            void value(ConfigReal real) {
+                if (!std::isfinite(real)) {
+                    throw ConfigWriterError("Unable to write non-finite real");
+                }
+                beginValue();
+                // FLT_MAX has 39 digits, the smallest denormal 45 decimal places
+                char text[64];
+                auto result = std::to_chars(text, text + sizeof(text), real, std::chars_format::fixed);
+                buffer.append(text, result.ptr - text);
+                if (!std::memchr(text, '.', result.ptr - text)) {
+                    buffer += ".0";
+                }
+                maybeFlush();
+            }
+
+            void value(const std::string &str) {
+                beginValue();
+                buffer += '"';
+                escape(str, buffer);
+                buffer += '"';
+                maybeFlush();
+            }
+
+            void value(const char *str) {
+                value(std::string(str));
+            }
+
+            void value(ConfigBool boolean) {
+                beginValue();
+                buffer += boolean ? "true" : "false";
+                maybeFlush();
+            }
+
+            void value(ConfigNil nil) {
+                beginValue();
+                buffer += "nil";
+                maybeFlush();
+            }
+
+            /**
+             * Writes all buffered output.
+             */
+            void flush() {
+                if (buffer.empty()) {
+                    return;
+                }
+
+                if (stream) {
+                    stream->write(buffer.data(), buffer.size());
+                    if (!*stream) {
+                        throw ConfigWriterError("Unable to write to stream");
+                    }
+                } else {
+                    size_t written = 0;
+                    while (written < buffer.size()) {
+                        ssize_t result = write(fd, buffer.data() + written, buffer.size() - written);
+                        if (result < 0 && errno == EINTR) {
+                            continue;
+                        } else if (result < 0) {
+                            throw ConfigWriterError("Unable to write to file descriptor");
+                        }
+                        written += result;
+                    }
+                }
+                buffer.clear();
+            }
+
+            /**
+             * Returns:
+             *  true if the root value was completed
+             */
+            bool isComplete() {
+                return stack.empty() && wroteRoot;
+            }
+        private:
+            struct Level {
+                ObjectType type;
+                bool first;
+                bool hasKey;
+            };
+
+            void beginValue() {
+                if (stack.empty()) {
+                    if (wroteRoot) {
+                        throw ConfigWriterError("Document already has a root value");
+                    }
+                    wroteRoot = true;
+                    return;
+                }
+
+                auto &level = stack.back();
+                if (level.type == SECTION) {
+                    if (!level.hasKey) {
+                        throw ConfigWriterError("Section values require a key");
+                    }
+                    level.hasKey = false;
+                } else {
+                    separator();
+                }
+            }
+
+            void separator() {
+                auto &level = stack.back();
+                if (!level.first) {
+                    buffer += ", ";
+                }
+                level.first = false;
+            }
+
+            void endContainer(ObjectType type) {
+                if (stack.empty() || stack.back().type != type || stack.back().hasKey) {
+                    throw ConfigWriterError("Unbalanced end of section or list");
+                }
+                stack.pop_back();
+            }
+
+            void maybeFlush() {
+                if (buffer.size() >= bufferSize) {
+                    flush();
+                }
+            }
+
+            std::ostream *stream = nullptr;
+            int fd = -1;
+            size_t bufferSize;
+            std::string buffer;
+            std::vector<Level> stack;
+            bool wroteRoot = false;
+    };
+
+    /**
+     * Describes the expected shape of a document.
+     * IGNORE accepts any type.
+     * For lists the range applies to the amount of elements.
+     * Schemas are compiled once before parsing and checked by
+     * ConfigParser while tokens are consumed.
+     * A schema must not be modified while it is compiled or used by a parser.
+     */
+    class ConfigSchema: public std::enable_shared_from_this<ConfigSchema> {
+        public:
+            ConfigSchema(ObjectType type=IGNORE):
+                type(type), version(nextVersion()) {}
+
+            /**
+             * Returns:
+             *  the schema of the new key
+             */
+            std::shared_ptr<ConfigSchema> addKey(std::string name, ObjectType type, bool required=false) {
+                return addKey(name, std::make_shared<ConfigSchema>(type), required);
+            }
+
+            std::shared_ptr<ConfigSchema> addKey(std::string name, std::shared_ptr<ConfigSchema> schema, bool required=false) {
+                keys[name] = std::make_pair(schema, required);
+                changed();
+                return schema;
+            }
+
+            std::shared_ptr<ConfigSchema> setElements(ObjectType type) {
+                return setElements(std::make_shared<ConfigSchema>(type));
+            }
+
+            std::shared_ptr<ConfigSchema> setElements(std::shared_ptr<ConfigSchema> schema) {
+                elements = schema;
+                changed();
+                return schema;
+            }
+
+            void setRange(ConfigReal min, ConfigReal max) {
+                hasRange = true;
+                this->min = min;
+                this->max = max;
+                changed();
+            }
+
+            void setAllowed(std::vector<std::string> allowed) {
+                this->allowed = std::set<std::string>(allowed.begin(), allowed.end());
+                changed();
+            }
+
+            // if strict unknown keys are an error
+            void setStrict(bool strict) {
+                this->strict = strict;
+                changed();
+            }
+
+            void setNullable(bool nullable) {
+                this->nullable = nullable;
+                changed();
+            }
+
+            /**
+             * Returns:
+             *  a version that changes whenever this schema or any of its children is modified
+             */
+            unsigned long getVersion() const {
+                std::set<const ConfigSchema*> visited;
+                return getVersion(visited);
+            }
+
+            /**
+             * Assigns an index to every required key.
+             * Called by ConfigParser, only schemas modified since they were last compiled
+             * are compiled again. Compiling the same schemas from several threads is safe.
+             * Schemas may refer to themselves,
+             * such a cycle of shared pointers has to be broken by replacing the key.
+             */
+            void compile() {
+                std::lock_guard<std::mutex> lock(compileMutex());
+                std::set<ConfigSchema*> visited;
+                compile(visited);
+            }
+
+            /**
+             * Returns:
+             *  the key's schema and its required index (-1 if optional)
+             *  or nullptr if the key is unknown
+             */
+            const std::pair<ConfigSchema*, int>* findKey(const std::string &name) const {
+                auto found = compiledKeys.find(name);
+                if (found == compiledKeys.end()) {
+                    return nullptr;
+                }
+                return &found->second;
+            }
+
+            bool accepts(ObjectType actual) const {
+                if (type == IGNORE || type == actual) {
+                    return true;
+                }
+                if (actual == NIL) {
+                    return nullable;
+                }
+                // numbers are valid reals
+                return type == REAL && actual == NUMBER;
+            }
+
+            bool inRange(ConfigReal value) const {
+                return !hasRange || (value >= min && value <= max);
+            }
+
+            bool isAllowed(const std::string &value) const {
+                return allowed.empty() || allowed.find(value) != allowed.end();
+            }
+
+            ObjectType getType() const {
+                return type;
+            }
+
+            const ConfigSchema* getElements() const {
+                return elements.get();
+            }
+
+            bool isStrict() const {
+                return strict;
+            }
+
+            const std::vector<std::string>& getRequiredKeys() const {
+                return requiredKeys;
+            }
+        private:
+            /**
+             * Held while compiling, children may be shared by several schemas
+             */
+            static std::mutex& compileMutex() {
+                static std::mutex mutex;
+                return mutex;
+            }
+
+            /**
+             * Versions are unique so a change is never hidden by another schema's version
+             */
+            static unsigned long nextVersion() {
+                static std::atomic<unsigned long> counter { 1 };
+                return counter.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void changed() {
+                version = nextVersion();
+            }
+
+            // a change anywhere in the tree raises the newest version
+            unsigned long getVersion(std::set<const ConfigSchema*> &visited) const {
+                if (!visited.insert(this).second) {
+                    return 0;
+                }
+                unsigned long newest = version;
+                for (auto &key : keys) {
+                    newest = std::max(newest, key.second.first->getVersion(visited));
+                }
+                if (elements.get()) {
+                    newest = std::max(newest, elements->getVersion(visited));
+                }
+                return newest;
+            }
+
+            void compile(std::set<ConfigSchema*> &visited) {
+                if (!visited.insert(this).second) {
+                    return;
+                }
+
+                if (compiledVersion != version) {
+                    requiredKeys.clear();
+                    compiledKeys.clear();
+                    for (auto it = keys.begin(); it != keys.end(); it++) {
+                        int index = -1;
+                        if (it->second.second) {
+                            index = requiredKeys.size();
+                            requiredKeys.push_back(it->first);
+                        }
+                        compiledKeys[it->first] = std::make_pair(it->second.first.get(), index);
+                    }
+                    compiledVersion = version;
+                }
+
+                for (auto &key : keys) {
+                    key.second.first->compile(visited);
+                }
+                if (elements.get()) {
+                    elements->compile(visited);
+                }
+            }
+
+            ObjectType type;
+            std::map<std::string, std::pair<std::shared_ptr<ConfigSchema>, bool>> keys;
+            std::shared_ptr<ConfigSchema> elements;
+            bool hasRange = false;
+            ConfigReal min = 0;
+            ConfigReal max = 0;
+            std::set<std::string> allowed;
+            bool strict = false;
+            bool nullable = false;
+            // changes with this schema, children have their own
+            unsigned long version;
+
+            // set by compile
+            // version when compiledKeys and requiredKeys were built
+            unsigned long compiledVersion = 0;
+            std::map<std::string, std::pair<ConfigSchema*, int>> compiledKeys;
+            std::vector<std::string> requiredKeys;
+    };
+
+    /**
+     * Parsed include files keyed by path.
+     * An entry is reused as long as the mtime and size of the file
+     * and of every file it includes are unchanged.
+     * Parsers copy cached roots into their document, the cached roots are never modified.
+     */
+    class ConfigIncludeCache {
+        public:
+            // file a cached document was read from
+            struct File {
+                File(const std::string &path, const struct stat &info):
+                    path(path), mtime(info.st_mtim.tv_sec), mtimeNsec(info.st_mtim.tv_nsec),
+                    size(info.st_size) {}
+
+                /**
+                 * Returns:
+                 *  true if the file was modified or removed since it was read
+                 */
+                bool changed() const {
+                    struct stat info;
+                    return stat(path.c_str(), &info) != 0 || !matches(info);
+                }
+
+                bool matches(const struct stat &info) const {
+                    return mtime == info.st_mtim.tv_sec && mtimeNsec == info.st_mtim.tv_nsec
+                        && size == info.st_size;
+                }
+
+                std::string path;
+                time_t mtime;
+                long mtimeNsec;
+                off_t size;
+            };
+
+            /**
+             * Documents are cached per canonical path and the schema they were validated against.
+             * nodes and depth receive the amount of values and the nesting depth of the document,
+             * includes receives the files it includes directly or through other files.
+             */
+            std::shared_ptr<ConfigObject> find(const std::string &path, const struct stat &info,
+                    const ConfigSchema *schema=nullptr, size_t *nodes=nullptr, size_t *depth=nullptr,
+                    std::vector<File> *includes=nullptr) {
+                Entry entry;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto found = entries.find(std::make_pair(path, schema));
+                    if (found == entries.end()) {
+                        return std::shared_ptr<ConfigObject>(nullptr);
+                    }
+                    entry = found->second;
+                }
+                if (!entry.file.matches(info)
+                        // a new schema may live at the address of a released one
+                        || (schema && entry.schema.expired())
+                        || (schema && entry.schemaVersion != schema->getVersion())) {
+                    return std::shared_ptr<ConfigObject>(nullptr);
+                }
+                for (auto &file : entry.includes) {
+                    if (file.changed()) {
+                        return std::shared_ptr<ConfigObject>(nullptr);
+                    }
+                }
+                if (nodes) {
+                    *nodes = entry.nodes;
+                }
+                if (depth) {
+                    *depth = entry.depth;
+                }
+                if (includes) {
+                    *includes = entry.includes;
+                }
+                return entry.root;
+            }
+
+            void store(const std::string &path, const struct stat &info, std::shared_ptr<ConfigObject> root,
+                    const ConfigSchema *schema=nullptr, size_t nodes=0, size_t depth=0,
+                    const std::vector<File> &includes=std::vector<File>()) {
+                std::weak_ptr<const ConfigSchema> owner;
+                unsigned long schemaVersion = 0;
+                if (schema) {
+                    owner = schema->weak_from_this();
+                    schemaVersion = schema->getVersion();
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                entries[std::make_pair(path, schema)] = Entry { File(path, info), owner,
+                    schemaVersion, nodes, depth, root, includes };
+            }
+
+            size_t getSize() {
+                std::lock_guard<std::mutex> lock(mutex);
+                return entries.size();
+            }
+
+            void clear() {
+                std::lock_guard<std::mutex> lock(mutex);
+                entries.clear();
+            }
+        private:
+            struct Entry {
+                File file = File("", {});
+                std::weak_ptr<const ConfigSchema> schema;
+                unsigned long schemaVersion = 0;
+                size_t nodes = 0;
+                size_t depth = 0;
+                std::shared_ptr<ConfigObject> root;
+                std::vector<File> includes;
+            };
+
+            std::mutex mutex;
+            std::map<std::pair<std::string, const ConfigSchema*>, Entry> entries;
+    };
+
+    class ConfigParser {
+        private:
+            // open section or list
+            struct Frame {
+                ObjectType type;
+                std::shared_ptr<ConfigObject> node;
+                const ConfigSchema *schema = nullptr;
+                // sections
+                std::string key;
+                std::vector<bool> seenRequired;
+                // lists
+                const ConfigSchema *elements = nullptr;
+                std::shared_ptr<ConfigNumberArray> numbers;
+                std::shared_ptr<ConfigRealArray> reals;
+                TokenType packedType = EOF_T;
+                bool packed = false;
+            };
+        public:
+            ConfigParser(std::vector<std::shared_ptr<Token>> tokens):
+                tokens(tokens) {}
+
+            ConfigParser(std::string data, std::string path="", ConfigLimits limits=ConfigLimits(),
+                    ConfigStats *stats=nullptr):
+                limits(limits), stats(stats) {
+                ConfigScanner scanner(data, path, limits);
+                scanner.setStats(stats);
+                tokens = scanner.scanTokens();
+            }
+
+            /**
+             * Collects statistics in stats, nullptr disables them.
+             * Pass stats to the constructor to include scanning.
+             * Allocations are counted through the node pool or memory resource in use.
+             */
+            void setStats(ConfigStats *stats) {
+                this->stats = stats;
+            }
+
+            /**
+             * Depth and value limits, token and string limits
+             * only apply when the parser scans the input.
+             */
+            void setLimits(ConfigLimits limits) {
+                this->limits = limits;
+            }
+
+            /**
+             * Section keys are interned in table.
+             * By default every parser uses its own table which does not lock
+             * and lives as long as the parser,
+             * tables shared between threads have to be concurrent.
+             */
+            void setKeyTable(std::shared_ptr<ConfigKeyTable> table) {
+                keyTable = table;
+            }
+
+            std::shared_ptr<ConfigKeyTable> getKeyTable() {
+                return keyTable;
+            }
+
+            /**
+             * Nodes are allocated from pool if set.
+             */
+            void setNodePool(std::shared_ptr<ConfigNodePool> pool) {
+                nodePool = pool;
+            }
+
+            /**
+             * Nodes, sections, lists and packed values are allocated from resource.
+             * Takes precedence over a node pool.
+             * The resource has to outlive every parsed document.
+             * Included documents are cached beyond that and never use resource.
+             */
+            void setMemoryResource(std::pmr::memory_resource *resource) {
+                this->resource = resource;
+            }
+
+            /**
+             * Exchanges the token buffer and starts at the first token.
+             * Used to parse without copying the tokens.
+             */
+            void swapTokens(std::vector<std::shared_ptr<Token>> &tokens) {
+                this->tokens.swap(tokens);
+                current = 0;
+            }
+
+            /**
+             * Included files are parsed once per cache.
+             * By default every parser uses its own cache.
+             */
+            void setIncludeCache(std::shared_ptr<ConfigIncludeCache> cache) {
+                includeCache = cache;
+            }
+
+            /**
+             * Validates the document against schema while parsing.
+             */
+            void setSchema(std::shared_ptr<ConfigSchema> schema) {
+                schema->compile();
+                this->schema = schema;
+            }
+
+            std::shared_ptr<ConfigObject> parse() {
+                nodes = 0;
+                deepest = 0;
+                includedFiles.clear();
+                if (!stats) {
+                    return parseRoot(schema.get());
+                }
+
+                std::shared_ptr<ConfigObject> root;
+                {
+                    ConfigStatsTimer timer(stats, &ConfigStats::parseTime);
+                    root = parseRoot(schema.get());
+                }
+                stats->report();
+                return root;
+            }
+
+        private:
+            std::shared_ptr<ConfigObject> parseRoot(const ConfigSchema *schema) {
+                if (isAtEnd()) {
+                    // are we at the end already? if so return an empty object
+                    if (schema) {
+                        checkType(schema, SECTION, peek());
+                        if (schema->getRequiredKeys().size() > 0) {
+                            throw ConfigccSchemaError(peek(), SCHEMA_MISSING_KEY, schema->getRequiredKeys()[0]);
+                        }
+                    }
+                    return makeShared<ConfigObject>(SECTION, makeShared<ConfigSection>());
+                }
+
+                // root-level object
+                auto root = object(schema);
+                if (!isAtEnd()) {
+                    throw handleError(EXPECTED_EOF);
+                }
+
+                return root;
+            }
+
+            /**
+             * Parses one value.
+             * Open sections and lists are kept on an explicit stack
+             * so the native stack does not grow with the nesting depth.
+             */
+            std::shared_ptr<ConfigObject> object(const ConfigSchema *schema=nullptr) {
+                frames.clear();
+                auto value = open(schema);
+                while (!frames.empty()) {
+                    auto &frame = frames.back();
+                    if (!value.get()) {
+                        value = frame.type == SECTION ? nextInSection(frame) : nextInList(frame);
+                        continue;
+                    }
+
+                    if (frame.type == SECTION) {
+                        addObjectToSection(value, frame.key, frame.node);
+                    } else {
+                        addObjectToList(value, frame.node);
+                    }
+                    value.reset();
+
+                    if (!check(frame.type == SECTION ? RIGHT_BRACE : RIGHT_BRACKET) || check(COMMA)) {
+                        consume(COMMA, EXPECTED_COMMA);
+                    }
+                }
+                return value;
+            }
+
+            /**
+             * Returns:
+             *  the value or nullptr if a section or list was opened
+             */
+            std::shared_ptr<ConfigObject> open(const ConfigSchema *schema) {
+                if (check(LEFT_BRACE)) {
+                    openSection(schema);
+                    return std::shared_ptr<ConfigObject>(nullptr);
+                } else if (check(LEFT_BRACKET)) {
+                    openList(schema);
+                    return std::shared_ptr<ConfigObject>(nullptr);
+                }
+
+                countNode(peek());
+                std::shared_ptr<ConfigObject> value;
+                if (match(std::vector<TokenType> { TRUE, FALSE })) {
+                    value = boolean(schema);
+                } else if (check(NIL_TOKEN)) {
+                    value = nil(schema);
+                } else if (check(SECTION_NAME) && peek()->getLexemeView() == "include") {
+                    value = include(schema);
+                } else {
+                    value = literal(schema);
+                }
+
+                if (stats) {
+                    stats->nodes[value->getType()]++;
+                }
+                return value;
+            }
+
+            /**
+             * include "path"
+             * Relative paths are resolved from the including file's directory.
+             * Included documents are validated against the schema of the value they replace.
+             * Each include inserts a copy of the cached document so documents can be modified.
+             */
+            std::shared_ptr<ConfigObject> include(const ConfigSchema *schema=nullptr) {
+                auto directive = advance(); // include
+                auto pathToken = consume(STRING_TOKEN, EXPECTED_INCLUDE_PATH);
+                std::string path = pathToken->getLiteral().toString();
+
+                auto split = directive->getPath().find_last_of('/');
+                if (path.size() > 0 && path[0] != '/' && split != std::string::npos) {
+                    path = directive->getPath().substr(0, split+1) + path;
+                }
+
+                struct stat info;
+                if (stat(path.c_str(), &info) != 0) {
+                    throw ConfigccParserError(pathToken, INCLUDE_NOT_FOUND);
+                }
+
+                // ./a.cfg and a.cfg are the same document
+                auto canonicalPath = canonical(path);
+                auto current = canonical(directive->getPath());
+                if (canonicalPath == current
+                        || std::find(includeStack.begin(), includeStack.end(), canonicalPath) != includeStack.end()) {
+                    throw ConfigccParserError(pathToken, INCLUDE_CYCLE);
+                }
+
+                // limits apply to the document including everything it includes
+                size_t includedNodes = 0;
+                size_t includedDepth = 0;
+                std::vector<ConfigIncludeCache::File> files;
+                auto root = includeCache->find(canonicalPath, info, schema, &includedNodes, &includedDepth, &files);
+                if (root.get()) {
+                    if (limits.maxNodes && nodes + includedNodes > limits.maxNodes) {
+                        throw ConfigccLimitError(pathToken, NODE_LIMIT_EXCEEDED);
+                    }
+                    if (limits.maxDepth && depthOffset + frames.size() + includedDepth > limits.maxDepth) {
+                        throw ConfigccLimitError(pathToken, DEPTH_LIMIT_EXCEEDED);
+                    }
+                    nodes += includedNodes;
+                } else {
+                    std::ifstream file(path);
+                    if (!file) {
+                        throw ConfigccParserError(pathToken, INCLUDE_NOT_FOUND);
+                    }
+                    std::stringstream content;
+                    content << file.rdbuf();
+
+                    ConfigParser parser(content.str(), path, limits, stats);
+                    parser.keyTable = keyTable;
+                    parser.includeCache = includeCache;
+                    // cached documents may outlive the caller's memory resource
+                    parser.nodePool = nodePool;
+                    parser.includeStack = includeStack;
+                    parser.includeStack.push_back(current);
+                    parser.depthOffset = depthOffset + frames.size();
+                    parser.nodes = nodes;
+                    // reported as part of this document
+                    root = parser.parseRoot(schema);
+                    includedNodes = parser.nodes - nodes;
+                    includedDepth = parser.deepest;
+                    nodes = parser.nodes;
+                    files = parser.includedFiles;
+                    includeCache->store(canonicalPath, info, root, schema, includedNodes, includedDepth, files);
+                }
+                deepest = std::max(deepest, frames.size() + includedDepth);
+                // entries of the including documents depend on these files as well
+                includedFiles.push_back(ConfigIncludeCache::File(canonicalPath, info));
+                includedFiles.insert(includedFiles.end(), files.begin(), files.end());
+                return copy(root.get());
+            }
+
+            /**
+             * Copies a document with an explicit stack.
+             * Returns:
+             *  a copy that shares no containers with original
+             */
+            std::shared_ptr<ConfigObject> copy(const ConfigObject *original) {
+                std::vector<std::pair<const ConfigObject*, ConfigObject*>> pending;
+                auto root = copyNode(original, pending);
+                while (!pending.empty()) {
+                    auto from = pending.back().first;
+                    auto to = pending.back().second;
+                    pending.pop_back();
+                    if (from->isSection()) {
+                        auto &section = *from->castTo<const std::shared_ptr<ConfigSection>&>();
+                        auto &target = *to->castTo<const std::shared_ptr<ConfigSection>&>();
+                        for (auto &entry : section) {
+                            target.emplace_hint(target.end(), entry.first, copyNode(entry.second.get(), pending));
+                        }
+                    } else {
+                        auto &list = *from->castTo<const std::shared_ptr<ConfigList>&>();
+                        auto &target = *to->castTo<const std::shared_ptr<ConfigList>&>();
+                        target.reserve(list.size());
+                        for (auto &element : list) {
+                            target.push_back(copyNode(element.get(), pending));
+                        }
+                    }
+                }
+                return root;
+            }
+
+            // copies scalars and packed lists, containers are filled by copy
+            std::shared_ptr<ConfigObject> copyNode(const ConfigObject *original,
+                    std::vector<std::pair<const ConfigObject*, ConfigObject*>> &pending) {
+                if (original->isPacked()) {
+                    if (original->getPackedType() == NUMBER) {
+                        auto numbers = makeShared<ConfigNumberArray>();
+                        auto span = original->toNumberSpan();
+                        numbers->assign(span.begin(), span.end());
+                        return makeShared<ConfigObject>(numbers);
+                    }
+                    auto reals = makeShared<ConfigRealArray>();
+                    auto span = original->toRealSpan();
+                    reals->assign(span.begin(), span.end());
+                    return makeShared<ConfigObject>(reals);
+                }
+
+                std::shared_ptr<ConfigObject> node;
+                if (original->isSection()) {
+                    node = makeShared<ConfigObject>(SECTION, makeShared<ConfigSection>());
+                } else if (original->isList()) {
+                    node = makeShared<ConfigObject>(LIST, makeShared<ConfigList>());
+                } else {
+                    return makeShared<ConfigObject>(*original);
+                }
+                pending.push_back(std::make_pair(original, node.get()));
+                return node;
+            }
+
+            /**
+             * Returns:
+             *  the absolute path without links, or path if it does not exist
+             */
+            static std::string canonical(const std::string &path) {
+                char *resolved = realpath(path.c_str(), nullptr);
+                if (!resolved) {
+                    return path;
+                }
+                std::string result(resolved);
+                free(resolved);
+                return result;
+            }
+
+            void openSection(const ConfigSchema *schema) {
+                auto start = advance(); // {
+                checkType(schema, SECTION, start);
+                checkDepth(start);
+                countNode(start);
+
+                Frame frame;
+                frame.type = SECTION;
+                frame.schema = schema;
+                frame.node = makeShared<ConfigObject>(SECTION, makeShared<ConfigSection>());
+                frame.seenRequired.assign(schema ? schema->getRequiredKeys().size() : 0, false);
+                frames.push_back(std::move(frame));
+                recordContainer(SECTION);
+            }
+
+            /**
+             * name = value until end of section
+             */
+            std::shared_ptr<ConfigObject> nextInSection(Frame &frame) {
+                if (check(RIGHT_BRACE) || isAtEnd()) {
+                    auto end = consume(RIGHT_BRACE, MISSING_RIGHT_BRACE);
+                    for (size_t i = 0; i < frame.seenRequired.size(); i++) {
+                        if (!frame.seenRequired[i]) {
+                            throw ConfigccSchemaError(end, SCHEMA_MISSING_KEY, frame.schema->getRequiredKeys()[i]);
+                        }
+                    }
+
+                    auto root = frame.node;
+                    frames.pop_back();
+                    return root;
+                }
+
+                auto name = advance();
+                if (name->getType() == SECTION_NAME) {
+                    frame.key = name->getLexeme();
+                } else if (name->getType() == STRING_TOKEN) {
+                    frame.key = name->getLiteral().toString();
+                } else {
+                    throw handleError(EXPECTED_SECTION_NAME);
+                }
+
+                const ConfigSchema *keySchema = nullptr;
+                if (frame.schema) {
+                    auto key = frame.schema->findKey(frame.key);
+                    if (key) {
+                        keySchema = key->first;
+                        if (key->second >= 0) {
+                            frame.seenRequired[key->second] = true;
+                        }
+                    } else if (frame.schema->isStrict()) {
+                        throw ConfigccSchemaError(name, SCHEMA_UNKNOWN_KEY, frame.key);
+                    }
+                }
+
+                consume(EQUAL, EXPECTED_EQUAL);
+                return open(keySchema);
+            }
+
+            /**
+             * Lists that only contain NUMBER or only REAL values are stored packed.
+             * A list falls back to objects on the first element of another type.
+             */
+            void openList(const ConfigSchema *schema) {
+                auto start = advance(); // [
+                checkType(schema, LIST, start);
+                checkDepth(start);
+                countNode(start);
+
+                Frame frame;
+                frame.type = LIST;
+                frame.schema = schema;
+                frame.elements = schema ? schema->getElements() : nullptr;
+                frame.node = makeShared<ConfigObject>(LIST, makeShared<ConfigList>());
+                frame.numbers = makeShared<ConfigNumberArray>();
+                frame.reals = makeShared<ConfigRealArray>();
+                frame.packedType = peekNumberType();
+                frame.packed = frame.packedType != EOF_T;
+                frames.push_back(std::move(frame));
+                recordContainer(LIST);
+            }
+
+            /**
+             * [value value value... ]
+             * Returns:
+             *  nullptr after a packed element
+             */
+            std::shared_ptr<ConfigObject> nextInList(Frame &frame) {
+                if (check(RIGHT_BRACKET) || isAtEnd()) {
+                    auto end = consume(RIGHT_BRACKET, MISSING_RIGHT_BRACKET);
+                    auto root = frame.node;
+                    if (frame.packed) {
+                        root = frame.packedType == NUMBER_TOKEN ? makeShared<ConfigObject>(frame.numbers)
+                            : makeShared<ConfigObject>(frame.reals);
+                    }
+
+                    if (frame.schema && !frame.schema->inRange(root->getSize())) {
+                        throw ConfigccSchemaError(end, SCHEMA_OUT_OF_RANGE);
+                    }
+                    frames.pop_back();
+                    return root;
+                }
+
+                if (frame.packed && peekNumberType() == frame.packedType) {
+                    countNode(peek());
+                    auto sign = 1;
+                    if (match(std::vector<TokenType> {PLUS, MINUS}) && previous()->getType() == MINUS) {
+                        sign = -1;
+                    }
+                    auto token = advance();
+                    if (frame.packedType == NUMBER_TOKEN) {
+                        ConfigNumber value = token->getLiteral().toNumber() * sign;
+                        checkNumber(frame.elements, NUMBER, value, token);
+                        frame.numbers->push_back(value);
+                    } else {
+                        ConfigReal value = token->getLiteral().toReal() * sign;
+                        checkNumber(frame.elements, REAL, value, token);
+                        frame.reals->push_back(value);
+                    }
+                    if (stats) {
+                        stats->nodes[frame.packedType == NUMBER_TOKEN ? NUMBER : REAL]++;
+                    }
+
+                    if (!check(RIGHT_BRACKET) || check(COMMA)) {
+                        consume(COMMA, EXPECTED_COMMA);
+                    }
+                    return std::shared_ptr<ConfigObject>(nullptr);
+                }
+
+                if (frame.packed) {
+                    // not homogeneous, move packed values into the list
+                    frame.packed = false;
+                    for (auto number : *frame.numbers) {
+                        addObjectToList(makeShared<ConfigObject>(NUMBER, number), frame.node);
+                    }
+                    for (auto real : *frame.reals) {
+                        addObjectToList(makeShared<ConfigObject>(REAL, real), frame.node);
+                    }
+                }
+                return open(frame.elements);
+            }
+
+            void recordContainer(ObjectType type) {
+                if (stats) {
+                    stats->nodes[type]++;
+                    stats->maxDepth = std::max(stats->maxDepth, frames.size());
+                }
+            }
+
+            // called before a section or list is opened
+            void checkDepth(std::shared_ptr<Token> token) {
+                if (limits.maxDepth && depthOffset + frames.size() >= limits.maxDepth) {
+                    throw ConfigccLimitError(token, DEPTH_LIMIT_EXCEEDED);
+                }
+                deepest = std::max(deepest, frames.size() + 1);
+            }
+
+            // always counted so cached includes know their size
+            void countNode(std::shared_ptr<Token> token) {
+                if (++nodes > limits.maxNodes && limits.maxNodes) {
+                    throw ConfigccLimitError(token, NODE_LIMIT_EXCEEDED);
+                }
+            }
+
+            /**
+             * Returns:
+             *  NUMBER_TOKEN or REAL_TOKEN if the next value is a number, EOF_T otherwise
+             */
+            TokenType peekNumberType() {
+                auto token = peek();
+                if ((check(PLUS) || check(MINUS)) && current+1 < tokens.size()) {
+                    token = tokens[current+1];
+                }
+
+                if (token->getType() == NUMBER_TOKEN || token->getType() == REAL_TOKEN) {
+                    return token->getType();
+                }
+                return EOF_T;
+            }
+
+            std::shared_ptr<ConfigObject> boolean(const ConfigSchema *schema=nullptr) {
+                checkType(schema, BOOLEAN, previous());
+                return makeShared<ConfigObject>(BOOLEAN, previous()->getType() == TRUE);
+            }
+
+            std::shared_ptr<ConfigObject> nil(const ConfigSchema *schema=nullptr) {
+                checkType(schema, NIL, advance());
+                return makeShared<ConfigObject>(NIL, nullptr);
+            }
+
+            std::shared_ptr<ConfigObject> literal(const ConfigSchema *schema=nullptr) {
+                auto sign = 1;
+                if (match(std::vector<TokenType> {PLUS, MINUS})) {
+                    auto token = previous();
+                    if (token->getType() == MINUS) {
+                        sign = -1;
+                    }
+                }
+
+                if (match(std::vector<TokenType> {REAL_TOKEN})) {
+                    auto token = previous();
+                    auto literal = token->getLiteral();
+                    auto value = literal.toReal() * sign;
+                    checkNumber(schema, REAL, value, token);
+                    return makeShared<ConfigObject>(literal.getType(), value);
+                } else if (match(std::vector<TokenType> {NUMBER_TOKEN})) {
+                    auto token = previous();
+                    auto literal = token->getLiteral();
+                    auto value = literal.toNumber() * sign;
+                    checkNumber(schema, NUMBER, value, token);
+                    return makeShared<ConfigObject>(literal.getType(), value);
+                } else if (match(std::vector<TokenType> {STRING_TOKEN})) {
+                    auto token = previous();
+                    auto literal = token->getLiteral();
+                    checkType(schema, STRING, token);
+                    if (schema && !schema->isAllowed(literal.toString())) {
+                        throw ConfigccSchemaError(token, SCHEMA_INVALID_VALUE);
+                    }
+                    return makeShared<ConfigObject>(&literal);
+                }
+                throw handleError(UNEXPECTED_TOKEN);
+            }
+
+            template<typename T, typename... Args>
+            std::shared_ptr<T> makeShared(Args&&... args) {
+                if (stats && (resource || nodePool.get())) {
+                    return std::allocate_shared<T>(ConfigPoolAllocator<T>(counting()), std::forward<Args>(args)...);
+                } else if (resource || stats) {
+                    auto allocator = std::pmr::polymorphic_allocator<T>(resource ? resource : ConfigCountingResource::get());
+                    return std::allocate_shared<T>(allocator, std::forward<Args>(args)...);
+                } else if (nodePool.get()) {
+                    return std::allocate_shared<T>(ConfigPoolAllocator<T>(nodePool), std::forward<Args>(args)...);
+                }
+                return std::make_shared<T>(std::forward<Args>(args)...);
+            }
+
+            /**
+             * Returns:
+             *  a resource that counts the allocations of the resource or node pool in use
+             */
+            std::shared_ptr<ConfigCountingResource> counting() {
+                std::pmr::memory_resource *upstream = resource ? resource : nodePool.get();
+                if (!countingResource || countingResource->getUpstream() != upstream) {
+                    countingResource = std::make_shared<ConfigCountingResource>(upstream,
+                            resource ? nullptr : nodePool);
+                }
+                return countingResource;
+            }
+
+            void checkType(const ConfigSchema *schema, ObjectType actual, std::shared_ptr<Token> token) {
+                if (schema && !schema->accepts(actual)) {
+                    throw ConfigccSchemaError(token, SCHEMA_TYPE_ERROR);
+                }
+            }
+
+            void checkNumber(const ConfigSchema *schema, ObjectType actual, ConfigReal value, std::shared_ptr<Token> token) {
+                checkType(schema, actual, token);
+                if (schema && !schema->inRange(value)) {
+                    throw ConfigccSchemaError(token, SCHEMA_OUT_OF_RANGE);
+                }
+            }
+
+            void addObjectToList(std::shared_ptr<ConfigObject> toAdd, std::shared_ptr<ConfigObject> list) {
+                auto objVector = list->toList();
+                objVector->push_back(toAdd);
+            }
+
+            // duplicate keys are replaced, the last value wins
+            void addObjectToSection(std::shared_ptr<ConfigObject> toAdd, std::string name,
+                    std::shared_ptr<ConfigObject> list) {
+                auto objMap = list->toSection();
+                (*objMap)[keyTable->intern(name)] = toAdd;
+            }
+
+
+            std::shared_ptr<Token> consume(TokenType token, ErrorType error, bool optional=false) {
+                if (check(token)) {
+                    return advance();
+                }
+
+                if (optional) {
+                    return std::shared_ptr<Token>(nullptr);
+                }
+
+                throw handleError(error);
+            }
+
+            bool match(std::vector<TokenType> types) {
+                for (auto it = types.begin(); it != types.end(); it++) {
+                    if (check(*it)) {
+                        advance();
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool check(TokenType type) {
+                return !isAtEnd() && peek()->getType() == type;
+            }
+
+            bool isAtEnd() {
+                return peek()->getType() == EOF_T;
+            }
+
+            std::shared_ptr<Token> advance() {
+                if (!isAtEnd()) {
+                    current++;
+                }
+                return previous();
+            }
+
+            std::shared_ptr<Token> peek() {
+                return tokens.at(current);
+            }
+
+            std::shared_ptr<Token> previous() {
+                return tokens.at(current-1);
+            }
+
+            ConfigccParserError handleError(ErrorType error, std::shared_ptr<Token> token=std::shared_ptr<Token>(nullptr)) {
+                if (!token.get()) {
+                    token = peek();
+                }
+                return ConfigccParserError(token, error);
+            }
+
+            unsigned long current = 0;
+            std::vector<std::shared_ptr<Token>> tokens;
+            std::shared_ptr<ConfigSchema> schema;
+            std::shared_ptr<ConfigKeyTable> keyTable = std::make_shared<ConfigKeyTable>(false);
+            std::shared_ptr<ConfigIncludeCache> includeCache = std::make_shared<ConfigIncludeCache>();
+            std::shared_ptr<ConfigNodePool> nodePool;
+            std::pmr::memory_resource *resource = nullptr;
+            std::shared_ptr<ConfigCountingResource> countingResource;
+            // paths of the files currently including this document
+            std::vector<std::string> includeStack;
+            ConfigLimits limits;
+            ConfigStats *stats = nullptr;
+            size_t nodes = 0;
+            // open containers of the including documents
+            size_t depthOffset = 0;
+            // most containers open at once
+            size_t deepest = 0;
+            // files included directly or through other files
+            std::vector<ConfigIncludeCache::File> includedFiles;
+            std::vector<Frame> frames;
+    };
+
+    /**
+     * Reusable state for parsing many small documents.
+     * The source buffer, token buffer, unreferenced tokens, interned keys,
+     * freed nodes and container storage are kept between documents,
+     * ConfigNodePool lists what still allocates.
+     * Not thread safe, keep one context per thread.
+     */
+    class ConfigParseContext {
+        public:
+            ConfigParseContext():
+                scanner(""), parser(std::vector<std::shared_ptr<Token>>()) {
+                parser.setNodePool(nodePool);
+            }
+
+            std::shared_ptr<ConfigObject> parse(const std::string &data, const std::string &path="") {
+                scanner.reset(data, path);
+                scanner.scanTokens();
+
+                parser.swapTokens(scanner.getTokens());
+                try {
+                    auto root = parser.parse();
+                    parser.swapTokens(scanner.getTokens());
+                    return root;
+                } catch (...) {
+                    parser.swapTokens(scanner.getTokens());
+                    throw;
+                }
+            }
+
+            /**
+             * Releases the last document without releasing capacity.
+             */
+            void reset() {
+                scanner.reset("");
+            }
+
+            void setSchema(std::shared_ptr<ConfigSchema> schema) {
+                parser.setSchema(schema);
+            }
+
+            void setKeyTable(std::shared_ptr<ConfigKeyTable> table) {
+                parser.setKeyTable(table);
+            }
+
+            std::shared_ptr<ConfigKeyTable> getKeyTable() {
+                return parser.getKeyTable();
+            }
+
+            void setIncludeCache(std::shared_ptr<ConfigIncludeCache> cache) {
+                parser.setIncludeCache(cache);
+            }
+
+            void setLimits(ConfigLimits limits) {
+                scanner.setLimits(limits);
+                parser.setLimits(limits);
+            }
+
+            /**
+             * Collects statistics of scanning and parsing in stats.
+             */
+            void setStats(ConfigStats *stats) {
+                scanner.setStats(stats);
+                parser.setStats(stats);
+            }
+
+            /**
+             * Used instead of the node pool.
+             * Reused tokens stay in the memory they were first allocated from,
+             * so resource has to outlive the context.
+             */
+            void setMemoryResource(std::pmr::memory_resource *resource) {
+                scanner.setMemoryResource(resource);
+                parser.setMemoryResource(resource);
+            }
+
+            std::shared_ptr<ConfigNodePool> getNodePool() {
+                return nodePool;
+            }
+
+            size_t getTokenCapacity() {
+                return scanner.getTokens().capacity();
+            }
+        private:
+            std::shared_ptr<ConfigNodePool> nodePool = std::make_shared<ConfigNodePool>();
+            ConfigScanner scanner;
+            ConfigParser parser;
+    };
+
+    /**
+     * Event based parser.
+     * Tokens are scanned on demand and no tree is built,
+     * memory use only depends on the nesting depth.
+     */
+    class ConfigEventParser {
+        public:
+            /**
+             * Nesting is handled recursively,
+             * set limits.maxDepth for untrusted input.
+             */
+            ConfigEventParser(std::string data, std::string path="", ConfigLimits limits=ConfigLimits()):
+                scanner(data, path, limits), limits(limits) {
+                current = scanner.nextToken();
+            }
+
+            void parse(ConfigEventHandler *handler) {
+                this->handler = handler;
+                if (isAtEnd()) {
+                    // empty document is an empty section
+                    if (handler->onSectionStart()) {
+                        handler->onSectionEnd();
+                    }
+                    return;
+                }
+
+                object(true);
+                if (!isAtEnd()) {
+                    throw handleError(EXPECTED_EOF);
+                }
+            }
+
+        private:
+            void object(bool emit) {
+                if (check(LEFT_BRACE)) {
+                    section(emit);
                 } else if (check(LEFT_BRACKET)) {
-                    return list();
-                } else if (match(std::vector<TokenType> { TRUE, FALSE })) {
-                    return boolean();
+                    list(emit);
+                } else if (check(TRUE) || check(FALSE)) {
+                    bool value = advance()->getType() == TRUE;
+                    if (emit) {
+                        handler->onBool(value);
+                    }
                 } else if (check(NIL_TOKEN)) {
-                    return nil();
+                    advance();
+                    if (emit) {
+                        handler->onNil();
+                    }
+                } else {
+                    literal(emit);
+                }
+            }
+
+            void section(bool emit) {
+                enter();
+                advance(); // {
+                emit = emit && handler->onSectionStart();
+
+                while (!check(RIGHT_BRACE) && !isAtEnd()) {
+                    auto name = advance();
+                    if (name->getType() == SECTION_NAME) {
+                        if (emit) {
+                            handler->onKey(name->getLexeme());
+                        }
+                    } else if (name->getType() == STRING_TOKEN) {
+                        if (emit) {
+                            handler->onKey(name->getLiteral().toString());
+                        }
+                    } else {
+                        throw handleError(EXPECTED_SECTION_NAME);
+                    }
+
+                    consume(EQUAL, EXPECTED_EQUAL);
+                    object(emit);
+
+                    if (!check(RIGHT_BRACE) || check(COMMA)) {
+                        consume(COMMA, EXPECTED_COMMA);
+                    }
+                }
+
+                consume(RIGHT_BRACE, MISSING_RIGHT_BRACE);
+                depth--;
+                if (emit) {
+                    handler->onSectionEnd();
+                }
+            }
+
+            void list(bool emit) {
+                enter();
+                advance(); // [
+                emit = emit && handler->onListStart();
+
+                while (!check(RIGHT_BRACKET) && !isAtEnd()) {
+                    object(emit);
+                    if (!check(RIGHT_BRACKET) || check(COMMA)) {
+                        consume(COMMA, EXPECTED_COMMA);
+                    }
+                }
+
+                consume(RIGHT_BRACKET, MISSING_RIGHT_BRACKET);
+                depth--;
+                if (emit) {
+                    handler->onListEnd();
+                }
+            }
+
+            void enter() {
+                if (limits.maxDepth && depth >= limits.maxDepth) {
+                    throw ConfigccLimitError(current, DEPTH_LIMIT_EXCEEDED);
+                }
+                depth++;
+            }
+
+            void literal(bool emit) {
+                auto sign = 1;
+                if (check(PLUS) || check(MINUS)) {
+                    if (advance()->getType() == MINUS) {
+                        sign = -1;
+                    }
+                }
+
+                if (check(REAL_TOKEN)) {
+                    auto value = advance()->getLiteral().toReal() * sign;
+                    if (emit) {
+                        handler->onReal(value);
+                    }
+                } else if (check(NUMBER_TOKEN)) {
+                    auto value = advance()->getLiteral().toNumber() * sign;
+                    if (emit) {
+                        handler->onNumber(value);
+                    }
+                } else if (check(STRING_TOKEN)) {
+                    auto token = advance();
+                    if (emit) {
+                        handler->onString(token->getLiteral().toString());
+                    }
+                } else {
+                    throw handleError(UNEXPECTED_TOKEN);
+                }
+            }
+
+            void consume(TokenType token, ErrorType error) {
+                if (!check(token)) {
+                    throw handleError(error);
+                }
+                advance();
+            }
+
+            bool check(TokenType type) {
+                return !isAtEnd() && current->getType() == type;
+            }
+
+            bool isAtEnd() {
+                return current->getType() == EOF_T;
+            }
+
+            std::shared_ptr<Token> advance() {
+                auto previous = current;
+                if (!isAtEnd()) {
+                    current = scanner.nextToken();
+                }
+                return previous;
+            }
+
+            ConfigccParserError handleError(ErrorType error) {
+                return ConfigccParserError(current, error);
+            }
+
+            ConfigScanner scanner;
+            std::shared_ptr<Token> current;
+            ConfigEventHandler *handler = nullptr;
+            ConfigLimits limits;
+            size_t depth = 0;
+    };
+
+    typedef std::function<void(std::shared_ptr<ConfigObject>)> ConfigDocumentCallback;
+
+    /**
+     * Push parser that accepts input in chunks of any size.
+     * Tokens, strings and escapes may be split across chunks.
+     * Every complete root value is passed to callback, so a stream may
+     * contain any number of back to back documents.
+     * After an exception the parser has to be reset.
+     */
+    class ConfigPushParser {
+        public:
+            ConfigPushParser(ConfigDocumentCallback callback, std::string path=""):
+                callback(callback), path(path) {}
+
+            void feed(const char *data, size_t length) {
+                for (size_t i = 0; i < length; i++) {
+                    scanChar(data[i]);
+                    if (data[i] == '\n') {
+                        lineStart = offset + 1;
+                    }
+                    offset++;
+                }
+            }
+
+            void feed(const std::string &data) {
+                feed(data.c_str(), data.size());
+            }
+
+            /**
+             * Ends the stream.
+             * An empty stream produces an empty section like ConfigParser.
+             */
+            void finish() {
+                endToken();
+                if (state == SCAN_STRING || state == SCAN_STRING_ESCAPE) {
+                    throw ConfigccScannerError(makeToken(EOF_T), UNTERMINATED_STRING);
+                } else if (state == SCAN_COMMENT_START) {
+                    throw ConfigccScannerError(makeToken(EOF_T), UNEXPECTED_TOKEN);
+                }
+
+                if (!stack.empty()) {
+                    throw ConfigccParserError(makeToken(EOF_T),
+                            stack.back().type == SECTION ? MISSING_RIGHT_BRACE : MISSING_RIGHT_BRACKET);
+                } else if (sign != 0) {
+                    throw ConfigccParserError(makeToken(EOF_T), UNEXPECTED_TOKEN);
+                }
+
+                if (documents == 0) {
+                    callback(std::make_shared<ConfigObject>(SECTION, std::make_shared<ConfigSection>()));
+                }
+                reset();
+            }
+
+            void reset() {
+                state = SCAN_IDLE;
+                text.clear();
+                stack.clear();
+                sign = 0;
+                line = 1;
+                offset = 0;
+                lineStart = 0;
+                documents = 0;
+                tokens = 0;
+                nodes = 0;
+            }
+
+            void setKeyTable(std::shared_ptr<ConfigKeyTable> table) {
+                keyTable = table;
+            }
+
+            /**
+             * Token and value limits apply per document.
+             */
+            void setLimits(ConfigLimits limits) {
+                this->limits = limits;
+            }
+        private:
+            enum ScanState {
+                SCAN_IDLE,
+                SCAN_STRING,
+                SCAN_STRING_ESCAPE,
+                SCAN_NUMBER,
+                SCAN_HEX,
+                SCAN_BIN,
+                SCAN_FRACTION_START,
+                SCAN_FRACTION,
+                SCAN_IDENTIFIER,
+                SCAN_COMMENT_START,
+                SCAN_COMMENT
+            };
+
+            enum FrameState {
+                EXPECT_KEY_OR_END,
+                EXPECT_EQUAL,
+                EXPECT_VALUE,
+                EXPECT_VALUE_OR_END,
+                EXPECT_COMMA_OR_END
+            };
+
+            struct Frame {
+                ObjectType type;
+                FrameState state;
+                std::shared_ptr<ConfigObject> node;
+                std::string key;
+            };
+
+            void scanChar(char c) {
+                switch (state) {
+                    case SCAN_STRING:
+                        if (c == '\n') {
+                            line++;
+                        }
+                        if (c == '\\') {
+                            state = SCAN_STRING_ESCAPE;
+                        } else if (c == quote) {
+                            state = SCAN_IDLE;
+                            token(STRING_TOKEN, ConfigObject(STRING, unescape(text)));
+                            return;
+                        }
+                        append(c);
+                        return;
+                    case SCAN_STRING_ESCAPE:
+                        if (c == '\n') {
+                            line++;
+                        }
+                        append(c);
+                        state = SCAN_STRING;
+                        return;
+                    case SCAN_NUMBER:
+                        if (text == "0" && (c == 'x' || c == 'b')) {
+                            append(c);
+                            state = c == 'x' ? SCAN_HEX : SCAN_BIN;
+                            return;
+                        } else if (scanner.isDigit(c)) {
+                            append(c);
+                            return;
+                        } else if (c == '.') {
+                            append(c);
+                            state = SCAN_FRACTION_START;
+                            return;
+                        }
+                        break;
+                    case SCAN_HEX:
+                        if (scanner.isHexDigit(c)) {
+                            append(c);
+                            return;
+                        }
+                        break;
+                    case SCAN_BIN:
+                        if (scanner.isBinDigit(c)) {
+                            append(c);
+                            return;
+                        }
+                        break;
+                    case SCAN_FRACTION_START:
+                        if (!scanner.isDigit(c)) {
+                            throw ConfigccScannerError(makeToken(EOF_T), UNEXPECTED_TOKEN);
+                        }
+                        append(c);
+                        state = SCAN_FRACTION;
+                        return;
+                    case SCAN_FRACTION:
+                        if (scanner.isDigit(c)) {
+                            append(c);
+                            return;
+                        }
+                        break;
+                    case SCAN_IDENTIFIER:
+                        if (scanner.isAlphaNumeric(c)) {
+                            append(c);
+                            return;
+                        }
+                        break;
+                    case SCAN_COMMENT_START:
+                        if (c != '/') {
+                            throw ConfigccScannerError(makeToken(EOF_T), UNEXPECTED_TOKEN);
+                        }
+                        state = SCAN_COMMENT;
+                        return;
+                    case SCAN_COMMENT:
+                        if (c != '\n') {
+                            return;
+                        }
+                        state = SCAN_IDLE;
+                        break;
+                    case SCAN_IDLE:
+                        break;
+                }
+
+                // the current token ended before c
+                endToken();
+                scanStart(c);
+            }
+
+            void scanStart(char c) {
+                tokenStart = offset;
+                text.assign(1, c);
+                switch (c) {
+                    case '{':
+                        token(LEFT_BRACE);
+                        break;
+                    case '}':
+                        token(RIGHT_BRACE);
+                        break;
+                    case '[':
+                        token(LEFT_BRACKET);
+                        break;
+                    case ']':
+                        token(RIGHT_BRACKET);
+                        break;
+                    case ',':
+                        token(COMMA);
+                        break;
+                    case '=':
+                        token(EQUAL);
+                        break;
+                    case '+':
+                        token(PLUS);
+                        break;
+                    case '-':
+                        token(MINUS);
+                        break;
+                    case '/':
+                        state = SCAN_COMMENT_START;
+                        break;
+                    case ' ':
+                    case '\t':
+                    case '\r':
+                        break;
+                    case '\n':
+                        line++;
+                        break;
+                    case '\'':
+                    case '"':
+                        quote = c;
+                        text.clear();
+                        state = SCAN_STRING;
+                        break;
+                    default:
+                        if (scanner.isDigit(c)) {
+                            state = SCAN_NUMBER;
+                        } else if (scanner.isAlpha(c)) {
+                            state = SCAN_IDENTIFIER;
+                        } else {
+                            throw ConfigccScannerError(makeToken(EOF_T), UNEXPECTED_TOKEN);
+                        }
+                }
+            }
+
+            /**
+             * Emits a pending number or identifier
+             */
+            void endToken() {
+                ScanState ended = state;
+                if (ended == SCAN_COMMENT || ended == SCAN_STRING || ended == SCAN_STRING_ESCAPE
+                        || ended == SCAN_COMMENT_START || ended == SCAN_IDLE) {
+                    return;
+                }
+                state = SCAN_IDLE;
+
+                if (ended == SCAN_IDENTIFIER) {
+                    if (text == "true") {
+                        token(TRUE);
+                    } else if (text == "false") {
+                        token(FALSE);
+                    } else if (text == "nil") {
+                        token(NIL_TOKEN);
+                    } else {
+                        token(SECTION_NAME);
+                    }
+                    return;
+                }
+
+                try {
+                    if (ended == SCAN_FRACTION) {
+                        token(REAL_TOKEN, ConfigObject(REAL, (ConfigReal)std::stod(text)));
+                    } else if (ended == SCAN_HEX) {
+                        token(NUMBER_TOKEN, ConfigObject(NUMBER, (ConfigNumber)std::stol(text, nullptr, 16)));
+                    } else if (ended == SCAN_BIN) {
+                        token(NUMBER_TOKEN, ConfigObject(NUMBER, (ConfigNumber)std::stol(text.substr(2), nullptr, 2)));
+                    } else if (ended == SCAN_FRACTION_START) {
+                        throw ConfigccScannerError(makeToken(EOF_T), UNEXPECTED_TOKEN);
+                    } else {
+                        token(NUMBER_TOKEN, ConfigObject(NUMBER, (ConfigNumber)std::stol(text)));
+                    }
+                } catch (std::logic_error &e) {
+                    throw ConfigccScannerError(makeToken(EOF_T), NUMBER_PARSE_ERROR);
+                }
+            }
+
+            void append(char c) {
+                if (limits.maxStringLength && text.size() >= limits.maxStringLength) {
+                    throw ConfigccLimitError(makeToken(EOF_T), STRING_LIMIT_EXCEEDED);
+                }
+                text += c;
+            }
+
+            void token(TokenType type, ConfigObject literal=ConfigObject(NIL, nullptr)) {
+                if (limits.maxTokens && ++tokens > limits.maxTokens) {
+                    throw ConfigccLimitError(makeToken(type), TOKEN_LIMIT_EXCEEDED);
+                }
+
+                if (stack.empty()) {
+                    value(type, literal);
+                    return;
+                }
+
+                auto &frame = stack.back();
+                switch (frame.state) {
+                    case EXPECT_KEY_OR_END:
+                        if (type == RIGHT_BRACE) {
+                            close();
+                        } else if (type == SECTION_NAME) {
+                            frame.key = text;
+                            frame.state = EXPECT_EQUAL;
+                        } else if (type == STRING_TOKEN) {
+                            frame.key = literal.toString();
+                            frame.state = EXPECT_EQUAL;
+                        } else {
+                            throw ConfigccParserError(makeToken(type), EXPECTED_SECTION_NAME);
+                        }
+                        break;
+                    case EXPECT_EQUAL:
+                        if (type != EQUAL) {
+                            throw ConfigccParserError(makeToken(type), EXPECTED_EQUAL);
+                        }
+                        frame.state = EXPECT_VALUE;
+                        break;
+                    case EXPECT_VALUE_OR_END:
+                        if (type == RIGHT_BRACKET) {
+                            close();
+                            break;
+                        }
+                        value(type, literal);
+                        break;
+                    case EXPECT_VALUE:
+                        value(type, literal);
+                        break;
+                    case EXPECT_COMMA_OR_END:
+                        if (type == COMMA) {
+                            frame.state = frame.type == SECTION ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END;
+                        } else if ((frame.type == SECTION && type == RIGHT_BRACE)
+                                || (frame.type == LIST && type == RIGHT_BRACKET)) {
+                            close();
+                        } else {
+                            throw ConfigccParserError(makeToken(type), EXPECTED_COMMA);
+                        }
+                        break;
                 }
-                return literal();
             }
 
-            std::shared_ptr<ConfigObject> section() {
-                advance(); // {
-                auto root = std::make_shared<ConfigObject>(ConfigObject(SECTION,
-                            std::make_shared<ConfigSection>()));
-                // name = value until end of section
-                while (!check(RIGHT_BRACE) && !isAtEnd()) {
-                    auto name = advance();
-                    std::string keyName = "";
-                    if (name->getType() == SECTION_NAME) {
-                        keyName = name->getLexeme();
-                    } else if (name->getType() == STRING_TOKEN) {
-                        keyName = name->getLiteral().toString();
+            void value(TokenType type, ConfigObject &literal) {
+                if (sign != 0 && type != NUMBER_TOKEN && type != REAL_TOKEN) {
+                    throw ConfigccParserError(makeToken(type), UNEXPECTED_TOKEN);
+                }
+
+                if (limits.maxNodes && (type != PLUS && type != MINUS) && ++nodes > limits.maxNodes) {
+                    throw ConfigccLimitError(makeToken(type), NODE_LIMIT_EXCEEDED);
+                } else if (limits.maxDepth && (type == LEFT_BRACE || type == LEFT_BRACKET)
+                        && stack.size() >= limits.maxDepth) {
+                    throw ConfigccLimitError(makeToken(type), DEPTH_LIMIT_EXCEEDED);
+                }
+
+                switch (type) {
+                    case LEFT_BRACE:
+                        stack.push_back(Frame { SECTION, EXPECT_KEY_OR_END,
+                                std::make_shared<ConfigObject>(SECTION, std::make_shared<ConfigSection>()), "" });
+                        break;
+                    case LEFT_BRACKET:
+                        stack.push_back(Frame { LIST, EXPECT_VALUE_OR_END,
+                                std::make_shared<ConfigObject>(LIST, std::make_shared<ConfigList>()), "" });
+                        break;
+                    case PLUS:
+                    case MINUS:
+                        if (sign != 0) {
+                            throw ConfigccParserError(makeToken(type), UNEXPECTED_TOKEN);
+                        }
+                        sign = type == MINUS ? -1 : 1;
+                        break;
+                    case NUMBER_TOKEN:
+                        attach(std::make_shared<ConfigObject>(NUMBER, literal.toNumber() * (sign ? sign : 1)));
+                        break;
+                    case REAL_TOKEN:
+                        attach(std::make_shared<ConfigObject>(REAL, literal.toReal() * (sign ? sign : 1)));
+                        break;
+                    case STRING_TOKEN:
+                        attach(std::make_shared<ConfigObject>(&literal));
+                        break;
+                    case TRUE:
+                    case FALSE:
+                        attach(std::make_shared<ConfigObject>(BOOLEAN, type == TRUE));
+                        break;
+                    case NIL_TOKEN:
+                        attach(std::make_shared<ConfigObject>(NIL, nullptr));
+                        break;
+                    default:
+                        throw ConfigccParserError(makeToken(type), UNEXPECTED_TOKEN);
+                }
+            }
+
+            void close() {
+                auto node = stack.back().node;
+                stack.pop_back();
+                attach(node);
+            }
+
+            void attach(std::shared_ptr<ConfigObject> node) {
+                sign = 0;
+                if (stack.empty()) {
+                    tokens = 0;
+                    nodes = 0;
+                    documents++;
+                    callback(node);
+                    return;
+                }
+
+                auto &frame = stack.back();
+                if (frame.type == SECTION) {
+                    (*frame.node->toSection())[keyTable->intern(frame.key)] = node;
+                } else {
+                    frame.node->toList()->push_back(node);
+                }
+                frame.state = EXPECT_COMMA_OR_END;
+            }
+
+            std::shared_ptr<Token> makeToken(TokenType type) {
+                return std::make_shared<Token>(type, ConfigObject(NIL, nullptr),
+                        std::make_shared<ConfigSource>(text, path, line, tokenStart,
+                            tokenStart >= lineStart ? tokenStart - lineStart + 1 : 1), tokenStart, text.size());
+            }
+
+            ConfigDocumentCallback callback;
+            std::string path;
+            std::shared_ptr<ConfigKeyTable> keyTable = std::make_shared<ConfigKeyTable>(false);
+            // only used for character classes
+            ConfigScanner scanner = ConfigScanner("");
+
+            ScanState state = SCAN_IDLE;
+            char quote = '"';
+            std::string text;
+            unsigned int line = 1;
+            unsigned int offset = 0;
+            unsigned int lineStart = 0;
+            unsigned int tokenStart = 0;
+
+            std::vector<Frame> stack;
+            int sign = 0;
+            unsigned long documents = 0;
+            ConfigLimits limits;
+            size_t tokens = 0;
+            size_t nodes = 0;
+    };
+
+    enum ConfigMergeMode {
+        // overlay value replaces base value
+        MERGE_REPLACE,
+        // sections are merged key by key
+        MERGE_DEEP,
+        // overlay list is appended to base list
+        MERGE_APPEND
+    };
+
+    /**
+     * Merges config layers without copying untouched subtrees.
+     * The result shares every object that was not overridden with its inputs,
+     * only sections on the path to an override are copied (one level each).
+     * Copying a level costs O(width of the lowest section) even if one key changed,
+     * all layers passed to one merge call share that copy.
+     * Inputs are not modified.
+     */
+    class ConfigMerger {
+        public:
+            ConfigMerger(ConfigMergeMode sectionMode=MERGE_DEEP, ConfigMergeMode listMode=MERGE_REPLACE):
+                sectionMode(sectionMode), listMode(listMode) {}
+
+            std::shared_ptr<ConfigObject> merge(std::shared_ptr<ConfigObject> base, std::shared_ptr<ConfigObject> overlay) {
+                if (base->isSection() && overlay->isSection() && sectionMode == MERGE_DEEP) {
+                    return mergeSections(std::vector<std::shared_ptr<ConfigObject>> {base, overlay});
+                } else if (base->isList() && overlay->isList() && listMode == MERGE_APPEND) {
+                    return appendLists(base, overlay);
+                }
+                return overlay;
+            }
+
+            /**
+             * Merges layers from first (lowest priority) to last.
+             */
+            std::shared_ptr<ConfigObject> merge(std::vector<std::shared_ptr<ConfigObject>> layers) {
+                if (layers.empty()) {
+                    return std::make_shared<ConfigObject>(SECTION, std::make_shared<ConfigSection>());
+                }
+                return mergeLayers(layers);
+            }
+        private:
+            std::shared_ptr<ConfigObject> mergeLayers(const std::vector<std::shared_ptr<ConfigObject>> &layers) {
+                // a value that is not a section replaces the sections below it,
+                // the sections above it are merged in one pass
+                size_t first = layers.size() - 1;
+                while (sectionMode == MERGE_DEEP && first > 0
+                        && layers[first]->isSection() && layers[first - 1]->isSection()) {
+                    first--;
+                }
+                if (first < layers.size() - 1) {
+                    return mergeSections(std::vector<std::shared_ptr<ConfigObject>>(layers.begin() + first, layers.end()));
+                }
+
+                auto result = layers[0];
+                for (size_t i = 1; i < layers.size(); i++) {
+                    result = merge(result, layers[i]);
+                }
+                return result;
+            }
+
+            /**
+             * Copies the pointers of the first section once
+             * and merges the values of every key that the other sections set.
+             */
+            std::shared_ptr<ConfigObject> mergeSections(const std::vector<std::shared_ptr<ConfigObject>> &sections) {
+                std::map<ConfigKey, std::vector<std::shared_ptr<ConfigObject>>, ConfigKeyLess> overrides;
+                for (size_t i = 1; i < sections.size(); i++) {
+                    auto section = sections[i]->toSection();
+                    for (auto it = section->begin(); it != section->end(); it++) {
+                        overrides[it->first].push_back(it->second);
+                    }
+                }
+                if (overrides.empty()) {
+                    return sections[0];
+                }
+
+                auto merged = std::make_shared<ConfigSection>(*sections[0]->toSection());
+                for (auto &entry : overrides) {
+                    auto found = merged->find(entry.first);
+                    if (found == merged->end()) {
+                        (*merged)[entry.first] = entry.second.size() == 1 ? entry.second[0] : mergeLayers(entry.second);
                     } else {
-                        throw handleError(EXPECTED_SECTION_NAME);
+                        entry.second.insert(entry.second.begin(), found->second);
+                        found->second = mergeLayers(entry.second);
                     }
+                }
+                return std::make_shared<ConfigObject>(SECTION, merged);
+            }
 
-                    consume(EQUAL, EXPECTED_EQUAL);
-                    auto value = object();
+            std::shared_ptr<ConfigObject> appendLists(std::shared_ptr<ConfigObject> base, std::shared_ptr<ConfigObject> overlay) {
+                if (base->getPackedType() == NUMBER && overlay->getPackedType() == NUMBER) {
+                    return appendPacked<ConfigNumber>(base->toNumberSpan(), overlay->toNumberSpan());
+                } else if (base->getPackedType() == REAL && overlay->getPackedType() == REAL) {
+                    return appendPacked<ConfigReal>(base->toRealSpan(), overlay->toRealSpan());
+                }
 
-                    addObjectToSection(value, keyName, root);
+                auto baseList = elementsOf(*base);
+                auto overlayList = elementsOf(*overlay);
 
-                    if (!check(RIGHT_BRACE) || check(COMMA)) {
-                        consume(COMMA, EXPECTED_COMMA);
-                    }
+                auto merged = std::make_shared<ConfigList>();
+                merged->reserve(baseList->size() + overlayList->size());
+                merged->insert(merged->end(), baseList->begin(), baseList->end());
+                merged->insert(merged->end(), overlayList->begin(), overlayList->end());
+                return std::make_shared<ConfigObject>(LIST, merged);
+            }
+
+            // reading does not unpack the inputs, packed lists are unpacked into a copy
+            static std::shared_ptr<ConfigList> elementsOf(const ConfigObject &list) {
+                ConfigObject copy(list);
+                return copy.toList();
+            }
+
+            template<typename T>
+            std::shared_ptr<ConfigObject> appendPacked(ConfigSpan<T> base, ConfigSpan<T> overlay) {
+                auto merged = std::make_shared<ConfigPackedArray<T>>();
+                merged->reserve(base.size() + overlay.size());
+                merged->insert(merged->end(), base.begin(), base.end());
+                merged->insert(merged->end(), overlay.begin(), overlay.end());
+                return std::make_shared<ConfigObject>(merged);
+            }
+
+            ConfigMergeMode sectionMode;
+            ConfigMergeMode listMode;
+    };
+
+    /**
+     * Scalar key of a ConfigIndex.
+     * Numbers and reals are compared by value,
+     * reals with the precision of ConfigReal.
+     */
+    class ConfigIndexKey {
+        public:
+            ConfigIndexKey(const std::string &text):
+                type(STRING), text(text) {}
+
+            ConfigIndexKey(const char *text):
+                type(STRING), text(text) {}
+
+            ConfigIndexKey(ConfigNumber number):
+                type(NUMBER), number(number) {}
+
+            ConfigIndexKey(ConfigReal number):
+                type(NUMBER), number(number) {}
+
+            // double literals match the ConfigReal they are stored as
+            ConfigIndexKey(double number):
+                type(NUMBER), number(static_cast<ConfigReal>(number)) {}
+
+            ConfigIndexKey(ConfigBool flag):
+                type(BOOLEAN), number(flag) {}
+
+            /**
+             * Stores the key of value in key.
+             * Returns:
+             *  false if value is not a scalar
+             */
+            static bool of(const ConfigObject &value, ConfigIndexKey &key) {
+                switch (value.getType()) {
+                    case STRING:
+                        key = ConfigIndexKey(value.toString());
+                        return true;
+                    case NUMBER:
+                        key = ConfigIndexKey(value.toNumber());
+                        return true;
+                    case REAL:
+                        key = ConfigIndexKey(value.toReal());
+                        return true;
+                    case BOOLEAN:
+                        key = ConfigIndexKey(value.toBool());
+                        return true;
+                    default:
+                        return false;
                 }
+            }
 
-                consume(RIGHT_BRACE, MISSING_RIGHT_BRACE);
+            bool operator==(const ConfigIndexKey &other) const {
+                return type == other.type && number == other.number && text == other.text;
+            }
 
-                return root;
+            bool operator<(const ConfigIndexKey &other) const {
+                if (type != other.type) {
+                    return type < other.type;
+                } else if (type == STRING) {
+                    return text < other.text;
+                }
+                return number < other.number;
             }
 
-            std::shared_ptr<ConfigObject> list() {
-                advance(); // [
-                auto root = std::make_shared<ConfigObject>(ConfigObject(LIST,
-                            std::make_shared<ConfigList>()));
-                // [value value value... ]
-                while (!check(RIGHT_BRACKET) && !isAtEnd()) {
-                    auto value = object();
-                    addObjectToList(value, root);
-                    if (!check(RIGHT_BRACKET) || check(COMMA)) {
-                        consume(COMMA, EXPECTED_COMMA);
-                    }
+            size_t hash() const {
+                if (type == STRING) {
+                    return std::hash<std::string>()(text);
                 }
+                return std::hash<double>()(number) ^ type;
+            }
+        private:
+            ObjectType type;
+            double number = 0;
+            std::string text;
+    };
 
-                consume(RIGHT_BRACKET, MISSING_RIGHT_BRACKET);
+    struct ConfigIndexKeyHash {
+        size_t operator()(const ConfigIndexKey &key) const {
+            return key.hash();
+        }
+    };
 
-                return root;
+    enum ConfigIndexType {
+        // O(1) lookups
+        INDEX_HASH,
+        // O(log n) lookups and ordered ranges
+        INDEX_SORTED
+    };
+
+    /**
+     * Secondary index over a list of sections.
+     * Each section is indexed by the scalar at keyPath,
+     * a path of keys separated by . e.g. meta.id.
+     * An empty keyPath indexes a list of scalars by their value,
+     * packed lists are indexed without unpacking them.
+     * Elements that are not sections or do not have a scalar at keyPath are skipped.
+     * The list must not be modified while the index is used.
+     */
+    class ConfigIndex {
+        public:
+            ConfigIndex(std::shared_ptr<const ConfigObject> list, const std::string &keyPath,
+                    ConfigIndexType type=INDEX_HASH, ConfigStats *stats=nullptr):
+                list(list), keyPath(keyPath), type(type) {
+                {
+                    ConfigStatsTimer timer(stats, &ConfigStats::indexTime);
+                    build();
+                }
+                if (stats) {
+                    stats->indexes++;
+                    stats->indexedEntries += entries.size();
+                    stats->report();
+                }
             }
 
-            std::shared_ptr<ConfigObject> boolean() {
-                return std::make_shared<ConfigObject>(ConfigObject(BOOLEAN, previous()->getType() == TRUE));
+            /**
+             * Returns:
+             *  the first element in list order with key or nullptr
+             */
+            std::shared_ptr<const ConfigObject> find(const ConfigIndexKey &key) const {
+                size_t position = first(key);
+                if (position == entries.size()) {
+                    return nullptr;
+                }
+                return list->get(entries[position].second);
             }
 
-            std::shared_ptr<ConfigObject> nil() {
-                advance();
-                return std::make_shared<ConfigObject>(ConfigObject(NIL, nullptr));
+            /**
+             * Returns:
+             *  every element with key in list order
+             */
+            std::vector<std::shared_ptr<const ConfigObject>> findAll(const ConfigIndexKey &key) const {
+                std::vector<std::shared_ptr<const ConfigObject>> result;
+                for (size_t position = first(key); position < entries.size(); position = next(position, key)) {
+                    result.push_back(list->get(entries[position].second));
+                }
+                return result;
             }
 
-            std::shared_ptr<ConfigObject> literal() {
-                auto sign = 1;
-                if (match(std::vector<TokenType> {PLUS, MINUS})) {
-                    auto token = previous();
-                    if (token->getType() == MINUS) {
-                        sign = -1;
+            /**
+             * Returns:
+             *  every element with lower <= key < upper ordered by key,
+             *  hash indexes have to scan all entries
+             */
+            std::vector<std::shared_ptr<const ConfigObject>> findRange(const ConfigIndexKey &lower,
+                    const ConfigIndexKey &upper) const {
+                std::vector<std::shared_ptr<const ConfigObject>> result;
+                if (type == INDEX_SORTED) {
+                    auto begin = std::lower_bound(entries.begin(), entries.end(), lower, EntryLess());
+                    auto end = std::lower_bound(begin, entries.end(), upper, EntryLess());
+                    for (auto entry = begin; entry != end; entry++) {
+                        result.push_back(list->get(entry->second));
                     }
+                    return result;
                 }
 
-                if (match(std::vector<TokenType> {REAL_TOKEN})) {
-                    auto token = previous();
-                    auto literal = token->getLiteral();
-                    return std::make_shared<ConfigObject>(ConfigObject(literal.getType(), literal.toReal() * sign));
-                } else if (match(std::vector<TokenType> {NUMBER_TOKEN})) {
-                    auto token = previous();
-                    auto literal = token->getLiteral();
-                    return std::make_shared<ConfigObject>(ConfigObject(literal.getType(), literal.toNumber() * sign));
-                } else if (match(std::vector<TokenType> {STRING_TOKEN})) {
-                    auto token = previous();
-                    auto literal = token->getLiteral();
-                    return std::make_shared<ConfigObject>(ConfigObject(&literal));
+                std::vector<Entry> matches;
+                for (auto &entry : entries) {
+                    if (!(entry.first < lower) && entry.first < upper) {
+                        matches.push_back(entry);
+                    }
                 }
-                throw handleError(UNEXPECTED_TOKEN);
+                std::stable_sort(matches.begin(), matches.end(), EntryLess());
+                for (auto &entry : matches) {
+                    result.push_back(list->get(entry.second));
+                }
+                return result;
             }
 
-            void addObjectToList(std::shared_ptr<ConfigObject> toAdd, std::shared_ptr<ConfigObject> list) {
-                auto objVector = list->toList();
-                objVector->push_back(toAdd);
+            size_t count(const ConfigIndexKey &key) const {
+                size_t matches = 0;
+                for (size_t position = first(key); position < entries.size(); position = next(position, key)) {
+                    matches++;
+                }
+                return matches;
             }
 
-            void addObjectToSection(std::shared_ptr<ConfigObject> toAdd, std::string name,
-                    std::shared_ptr<ConfigObject> list) {
-                auto objMap = list->toSection();
-                objMap->insert(std::pair<std::string, std::shared_ptr<ConfigObject>>(name, toAdd));
+            /**
+             * Returns:
+             *  the amount of indexed elements
+             */
+            size_t getSize() const {
+                return entries.size();
             }
 
+            ConfigIndexType getType() const {
+                return type;
+            }
 
-            std::shared_ptr<Token> consume(TokenType token, ErrorType error, bool optional=false) {
-                if (check(token)) {
-                    return advance();
+            const std::string& getKeyPath() const {
+                return keyPath;
+            }
+        private:
+            typedef std::pair<ConfigIndexKey, size_t> Entry;
+
+            struct EntryLess {
+                bool operator()(const Entry &a, const Entry &b) const {
+                    return a.first < b.first;
                 }
 
-                if (optional) {
-                    return std::shared_ptr<Token>(nullptr);
+                bool operator()(const Entry &a, const ConfigIndexKey &b) const {
+                    return a.first < b;
                 }
 
-                throw handleError(error);
+                bool operator()(const ConfigIndexKey &a, const Entry &b) const {
+                    return a < b.first;
+                }
+            };
+
+            void build() {
+                if (!list->isList()) {
+                    return;
+                } else if (list->isPacked()) {
+                    if (keyPath.empty()) {
+                        buildPacked();
+                    }
+                    return;
+                }
+
+                std::vector<std::string> path;
+                std::stringstream stream(keyPath);
+                for (std::string key; std::getline(stream, key, '.');) {
+                    path.push_back(key);
+                }
+
+                auto &elements = *list->castTo<const std::shared_ptr<ConfigList>&>();
+                ConfigIndexKey key(false);
+                for (size_t index = 0; index < elements.size(); index++) {
+                    const ConfigObject *value = elements[index].get();
+                    for (auto &name : path) {
+                        if (!value->isSection()) {
+                            value = nullptr;
+                            break;
+                        }
+                        auto &section = *value->castTo<const std::shared_ptr<ConfigSection>&>();
+                        auto found = section.find(name);
+                        if (found == section.end()) {
+                            value = nullptr;
+                            break;
+                        }
+                        value = found->second.get();
+                    }
+                    if (value && ConfigIndexKey::of(*value, key)) {
+                        entries.push_back(Entry(key, index));
+                    }
+                }
+                order();
             }
 
-            bool match(std::vector<TokenType> types) {
-                for (auto it = types.begin(); it != types.end(); it++) {
-                    if (check(*it)) {
-                        advance();
-                        return true;
+            // matches are returned by list index, elements are only unpacked when requested
+            void buildPacked() {
+                if (list->getPackedType() == NUMBER) {
+                    auto numbers = list->toNumberSpan();
+                    for (size_t index = 0; index < numbers.size(); index++) {
+                        entries.push_back(Entry(ConfigIndexKey(numbers[index]), index));
+                    }
+                } else {
+                    auto reals = list->toRealSpan();
+                    for (size_t index = 0; index < reals.size(); index++) {
+                        entries.push_back(Entry(ConfigIndexKey(reals[index]), index));
                     }
                 }
-                return false;
+                order();
             }
 
-            bool check(TokenType type) {
-                return !isAtEnd() && peek()->getType() == type;
+            void order() {
+                if (type == INDEX_SORTED) {
+                    // equal keys stay in list order
+                    std::stable_sort(entries.begin(), entries.end(), EntryLess());
+                    return;
+                }
+
+                // chains entries with equal keys in list order
+                chain.assign(entries.size(), entries.size());
+                firsts.reserve(entries.size());
+                std::unordered_map<ConfigIndexKey, size_t, ConfigIndexKeyHash> lasts;
+                for (size_t position = 0; position < entries.size(); position++) {
+                    auto inserted = firsts.emplace(entries[position].first, position);
+                    if (!inserted.second) {
+                        chain[lasts[entries[position].first]] = position;
+                    }
+                    lasts[entries[position].first] = position;
+                }
             }
 
-            bool isAtEnd() {
-                return peek()->getType() == EOF_T;
+            size_t first(const ConfigIndexKey &key) const {
+                if (type == INDEX_SORTED) {
+                    auto found = std::lower_bound(entries.begin(), entries.end(), key, EntryLess());
+                    if (found == entries.end() || !(found->first == key)) {
+                        return entries.size();
+                    }
+                    return found - entries.begin();
+                }
+
+                auto found = firsts.find(key);
+                if (found == firsts.end()) {
+                    return entries.size();
+                }
+                return found->second;
             }
 
-            std::shared_ptr<Token> advance() {
-                if (!isAtEnd()) {
-                    current++;
+            size_t next(size_t position, const ConfigIndexKey &key) const {
+                if (type == INDEX_SORTED) {
+                    position++;
+                    if (position < entries.size() && entries[position].first == key) {
+                        return position;
+                    }
+                    return entries.size();
                 }
-                return previous();
+                return chain[position];
             }
 
-            std::shared_ptr<Token> peek() {
-                return tokens.at(current);
+            std::shared_ptr<const ConfigObject> list;
+            std::string keyPath;
+            ConfigIndexType type;
+            // key and list index of every indexed element
+            std::vector<Entry> entries;
+            // hash index only
+            std::unordered_map<ConfigIndexKey, size_t, ConfigIndexKeyHash> firsts;
+            std::vector<size_t> chain;
+    };
+
+    /**
+     * Builds indexes the first time they are requested and keeps them.
+     * Indexes are identified by their list, so the document has to stay
+     * unmodified for the lifetime of the cache.
+     * Lookups are thread safe, keep the returned index on hot paths.
+     * Indexes are built outside the cache lock, concurrent requests
+     * for the same index wait for a single build.
+     * Builds are added to stats one at a time.
+     */
+    class ConfigIndexCache {
+        public:
+            std::shared_ptr<const ConfigIndex> get(std::shared_ptr<const ConfigObject> list,
+                    const std::string &keyPath, ConfigIndexType type=INDEX_HASH) {
+                std::shared_ptr<Slot> slot;
+                ConfigStats *stats;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto &found = indexes[std::make_tuple(list.get(), keyPath, type)];
+                    if (!found) {
+                        found = std::make_shared<Slot>();
+                    }
+                    slot = found;
+                    stats = this->stats;
+                }
+                // a failed build is retried by the next request
+                std::call_once(slot->built, [&]() {
+                    ConfigStats build;
+                    slot->index = std::make_shared<const ConfigIndex>(list, keyPath, type,
+                            stats ? &build : nullptr);
+                    if (stats) {
+                        std::lock_guard<std::mutex> lock(statsMutex);
+                        stats->indexTime += build.indexTime;
+                        stats->indexes += build.indexes;
+                        stats->indexedEntries += build.indexedEntries;
+                        stats->report();
+                    }
+                });
+                return slot->index;
             }
 
-            std::shared_ptr<Token> previous() {
-                return tokens.at(current-1);
+            /**
+             * Index builds are reported to stats, nullptr disables them.
+             */
+            void setStats(ConfigStats *stats) {
+                std::lock_guard<std::mutex> lock(mutex);
+                this->stats = stats;
             }
 
-            ConfigccParserError handleError(ErrorType error, std::shared_ptr<Token> token=std::shared_ptr<Token>(nullptr)) {
-                if (!token.get()) {
-                    token = peek();
+            size_t getSize() {
+                std::lock_guard<std::mutex> lock(mutex);
+                return indexes.size();
+            }
+
+            void clear() {
+                std::lock_guard<std::mutex> lock(mutex);
+                indexes.clear();
+            }
+        private:
+            struct Slot {
+                std::once_flag built;
+                std::shared_ptr<const ConfigIndex> index;
+            };
+
+            std::mutex mutex;
+            std::mutex statsMutex;
+            std::map<std::tuple<const ConfigObject*, std::string, ConfigIndexType>,
+                std::shared_ptr<Slot>> indexes;
+            ConfigStats *stats = nullptr;
+    };
+
+    /**
+     * Immutable version of a document.
+     * The root is only reachable as const.
+     */
+    class ConfigSnapshot {
+        public:
+            ConfigSnapshot(std::shared_ptr<ConfigObject> root, unsigned long version):
+                root(root), version(version) {}
+
+            std::shared_ptr<const ConfigObject> getRoot() const {
+                return root;
+            }
+
+            unsigned long getVersion() const {
+                return version;
+            }
+
+            /**
+             * Returns:
+             *  the index of list built on first use and released with the snapshot
+             */
+            std::shared_ptr<const ConfigIndex> getIndex(std::shared_ptr<const ConfigObject> list,
+                    const std::string &keyPath, ConfigIndexType type=INDEX_HASH) const {
+                return indexes.get(list, keyPath, type);
+            }
+
+            ConfigIndexCache& getIndexes() const {
+                return indexes;
+            }
+        private:
+            const std::shared_ptr<const ConfigObject> root;
+            const unsigned long version;
+            mutable ConfigIndexCache indexes;
+    };
+
+    /**
+     * Publishes new snapshots by swapping a pointer.
+     * Old snapshots are released once the last reader drops them.
+     */
+    class ConfigPublisher {
+        public:
+            ConfigPublisher(std::shared_ptr<ConfigObject> root=std::make_shared<ConfigObject>(SECTION,
+                        std::make_shared<ConfigSection>())):
+                current(std::make_shared<const ConfigSnapshot>(root, 0)) {}
+
+            /**
+             * Publishes root as the new version.
+             * root must not be modified afterwards.
+             * Returns:
+             *  the new version
+             */
+            unsigned long publish(std::shared_ptr<ConfigObject> root) {
+                std::lock_guard<std::mutex> lock(publishMutex);
+                unsigned long next = version.load(std::memory_order_relaxed) + 1;
+                std::atomic_store(&current, std::make_shared<const ConfigSnapshot>(root, next));
+                version.store(next, std::memory_order_release);
+                return next;
+            }
+
+            std::shared_ptr<const ConfigSnapshot> load() const {
+                return std::atomic_load(&current);
+            }
+
+            unsigned long getVersion() const {
+                return version.load(std::memory_order_acquire);
+            }
+        private:
+            std::shared_ptr<const ConfigSnapshot> current;
+            std::atomic<unsigned long> version { 0 };
+            std::mutex publishMutex;
+    };
+
+    /**
+     * Per thread handle to the latest snapshot of a publisher.
+     * get only reloads the snapshot after a new version was published,
+     * otherwise it is a single atomic load.
+     */
+    class ConfigReader {
+        public:
+            ConfigReader(const ConfigPublisher &publisher):
+                publisher(publisher), snapshot(publisher.load()) {}
+
+            const ConfigSnapshot& get() {
+                if (publisher.getVersion() != snapshot->getVersion()) {
+                    snapshot = publisher.load();
                 }
-                return ConfigccParserError(token, error);
+                return *snapshot;
             }
 
-            unsigned long current = 0;
-            std::vector<std::shared_ptr<Token>> tokens;
+            std::shared_ptr<const ConfigObject> getRoot() {
+                return get().getRoot();
+            }
+        private:
+            const ConfigPublisher &publisher;
+            std::shared_ptr<const ConfigSnapshot> snapshot;
     };
 }
 
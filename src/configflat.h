@@ -0,0 +1,609 @@
+/*
+Copyright 2021 Lukas Krickl (lukas@krickl.dev)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction,
+including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",
+WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CONFIGFLAT_H__
+#define __CONFIGFLAT_H__
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+#include "configcc.h"
+
+namespace liblc {
+    /**
+     * Entry of a ConfigFlat, path and strings are stored in the buffer of the ConfigFlat.
+     */
+    struct ConfigFlatRecord {
+        uint32_t path;
+        uint32_t pathLength;
+        ObjectType type;
+        union {
+            ConfigNumber number;
+            ConfigReal real;
+            ConfigBool flag;
+            // offset of a string, its length is stored in textLength
+            uint32_t text;
+        };
+        uint32_t textLength;
+    };
+
+    /**
+     * View of an entry, valid as long as its ConfigFlat is.
+     * Empty sections and lists are kept as entries of type SECTION and LIST.
+     */
+    class ConfigFlatEntry {
+        public:
+            ConfigFlatEntry(const char *buffer, const ConfigFlatRecord *record):
+                buffer(buffer), record(record) {}
+
+            std::string_view getPath() const {
+                return std::string_view(buffer + record->path, record->pathLength);
+            }
+
+            ObjectType getType() const {
+                return record->type;
+            }
+
+            ConfigNumber toNumber() const {
+                if (record->type == REAL) {
+                    return record->real;
+                }
+                checkType(NUMBER);
+                return record->number;
+            }
+
+            ConfigReal toReal() const {
+                if (record->type == NUMBER) {
+                    return record->number;
+                }
+                checkType(REAL);
+                return record->real;
+            }
+
+            ConfigBool toBool() const {
+                checkType(BOOLEAN);
+                return record->flag;
+            }
+
+            std::string_view toString() const {
+                checkType(STRING);
+                return std::string_view(buffer + record->text, record->textLength);
+            }
+
+            /**
+             * Returns:
+             *  true if both entries have the same path and value
+             */
+            bool operator==(const ConfigFlatEntry &other) const {
+                return getPath() == other.getPath() && sameValue(other);
+            }
+
+            bool operator!=(const ConfigFlatEntry &other) const {
+                return !(*this == other);
+            }
+
+            bool sameValue(const ConfigFlatEntry &other) const {
+                if (getType() != other.getType()) {
+                    return false;
+                }
+                switch (getType()) {
+                    case NUMBER:
+                        return record->number == other.record->number;
+                    case REAL:
+                        return record->real == other.record->real;
+                    case BOOLEAN:
+                        return record->flag == other.record->flag;
+                    case STRING:
+                        return toString() == other.toString();
+                    default:
+                        return true;
+                }
+            }
+
+            /**
+             * Returns:
+             *  the value as a new object
+             */
+            std::shared_ptr<ConfigObject> toObject() const {
+                switch (getType()) {
+                    case NUMBER:
+                        return std::make_shared<ConfigObject>(NUMBER, record->number);
+                    case REAL:
+                        return std::make_shared<ConfigObject>(REAL, record->real);
+                    case BOOLEAN:
+                        return std::make_shared<ConfigObject>(BOOLEAN, record->flag);
+                    case STRING:
+                        return std::make_shared<ConfigObject>(STRING, std::string(toString()));
+                    case LIST:
+                        return std::make_shared<ConfigObject>(LIST, std::make_shared<ConfigList>());
+                    case SECTION:
+                        return std::make_shared<ConfigObject>(SECTION, std::make_shared<ConfigSection>());
+                    default:
+                        return std::make_shared<ConfigObject>(NIL, nullptr);
+                }
+            }
+        private:
+            void checkType(ObjectType expected) const {
+                if (record->type != expected) {
+                    throw ConfigccTypeError(expected);
+                }
+            }
+
+            const char *buffer;
+            const ConfigFlatRecord *record;
+    };
+
+    class ConfigFlat;
+
+    /**
+     * Entries are returned by value, so this is an input iterator.
+     * Offsets and distances are still computed in O(1).
+     */
+    class ConfigFlatIterator {
+        public:
+            typedef std::input_iterator_tag iterator_category;
+            typedef ConfigFlatEntry value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef void pointer;
+            typedef ConfigFlatEntry reference;
+
+            // keeps the entry alive for operator->
+            struct Arrow {
+                ConfigFlatEntry entry;
+
+                const ConfigFlatEntry* operator->() const {
+                    return &entry;
+                }
+            };
+
+            ConfigFlatIterator(const char *buffer, const ConfigFlatRecord *record):
+                buffer(buffer), record(record) {}
+
+            ConfigFlatEntry operator*() const {
+                return ConfigFlatEntry(buffer, record);
+            }
+
+            Arrow operator->() const {
+                return Arrow { **this };
+            }
+
+            ConfigFlatEntry operator[](difference_type offset) const {
+                return ConfigFlatEntry(buffer, record + offset);
+            }
+
+            ConfigFlatIterator& operator++() {
+                record++;
+                return *this;
+            }
+
+            ConfigFlatIterator operator++(int) {
+                auto previous = *this;
+                record++;
+                return previous;
+            }
+
+            ConfigFlatIterator& operator--() {
+                record--;
+                return *this;
+            }
+
+            ConfigFlatIterator& operator+=(difference_type offset) {
+                record += offset;
+                return *this;
+            }
+
+            ConfigFlatIterator operator+(difference_type offset) const {
+                return ConfigFlatIterator(buffer, record + offset);
+            }
+
+            difference_type operator-(const ConfigFlatIterator &other) const {
+                return record - other.record;
+            }
+
+            bool operator==(const ConfigFlatIterator &other) const {
+                return record == other.record;
+            }
+
+            bool operator!=(const ConfigFlatIterator &other) const {
+                return record != other.record;
+            }
+
+            bool operator<(const ConfigFlatIterator &other) const {
+                return record < other.record;
+            }
+        private:
+            const char *buffer;
+            const ConfigFlatRecord *record;
+    };
+
+    /**
+     * Contiguous range of entries
+     */
+    class ConfigFlatRange {
+        public:
+            ConfigFlatRange(ConfigFlatIterator first, ConfigFlatIterator last):
+                first(first), last(last) {}
+
+            ConfigFlatIterator begin() const {
+                return first;
+            }
+
+            ConfigFlatIterator end() const {
+                return last;
+            }
+
+            size_t size() const {
+                return last - first;
+            }
+
+            bool empty() const {
+                return first == last;
+            }
+        private:
+            ConfigFlatIterator first;
+            ConfigFlatIterator last;
+    };
+
+    typedef std::function<void(std::string_view path, const ConfigFlatEntry *before,
+            const ConfigFlatEntry *after)> ConfigFlatDiffCallback;
+
+    /**
+     * Every scalar of a document as (path, value) entries sorted by path.
+     * Paths use the syntax of ConfigQuery: a.b[2].c, keys that are not
+     * made of letters, digits, _ : or - are quoted as ['key'].
+     * Paths compare bytewise, so a[10] is ordered before a[2].
+     * All paths and strings share one buffer.
+     */
+    class ConfigFlat {
+        public:
+            ConfigFlat(const ConfigObject &root) {
+                std::string path;
+                flatten(root, path);
+                std::sort(records.begin(), records.end(), [this](const ConfigFlatRecord &a, const ConfigFlatRecord &b) {
+                    return pathOf(a) < pathOf(b);
+                });
+            }
+
+            ConfigFlat(const std::shared_ptr<const ConfigObject> &root):
+                ConfigFlat(*root) {}
+
+            size_t getSize() const {
+                return records.size();
+            }
+
+            ConfigFlatEntry operator[](size_t index) const {
+                return ConfigFlatEntry(buffer.data(), &records[index]);
+            }
+
+            ConfigFlatIterator begin() const {
+                return ConfigFlatIterator(buffer.data(), records.data());
+            }
+
+            ConfigFlatIterator end() const {
+                return ConfigFlatIterator(buffer.data(), records.data() + records.size());
+            }
+
+            /**
+             * Returns:
+             *  the entry at path
+             */
+            std::optional<ConfigFlatEntry> find(std::string_view path) const {
+                auto found = lowerBound(path);
+                if (found == records.end() || pathOf(*found) != path) {
+                    return std::nullopt;
+                }
+                return ConfigFlatEntry(buffer.data(), &*found);
+            }
+
+            /**
+             * Returns:
+             *  every entry whose path starts with prefix,
+             *  use a trailing . or [ to only match children of a key
+             */
+            ConfigFlatRange scan(std::string_view prefix) const {
+                auto first = lowerBound(prefix);
+                auto last = std::partition_point(first, records.end(), [&](const ConfigFlatRecord &record) {
+                    return pathOf(record).substr(0, prefix.size()) == prefix;
+                });
+                return ConfigFlatRange(
+                        ConfigFlatIterator(buffer.data(), records.data() + (first - records.begin())),
+                        ConfigFlatIterator(buffer.data(), records.data() + (last - records.begin())));
+            }
+
+            /**
+             * Calls callback for every path that differs, before or after are
+             * nullptr if the path only exists on one side.
+             * Returns:
+             *  the amount of differences
+             */
+            size_t diff(const ConfigFlat &after, ConfigFlatDiffCallback callback=nullptr) const {
+                size_t changes = 0;
+                auto a = begin();
+                auto b = after.begin();
+                while (a != end() || b != after.end()) {
+                    if (b == after.end() || (a != end() && (*a).getPath() < (*b).getPath())) {
+                        auto removed = *a;
+                        changes++;
+                        if (callback) {
+                            callback(removed.getPath(), &removed, nullptr);
+                        }
+                        ++a;
+                    } else if (a == end() || (*b).getPath() < (*a).getPath()) {
+                        auto added = *b;
+                        changes++;
+                        if (callback) {
+                            callback(added.getPath(), nullptr, &added);
+                        }
+                        ++b;
+                    } else {
+                        auto before = *a;
+                        auto changed = *b;
+                        if (!before.sameValue(changed)) {
+                            changes++;
+                            if (callback) {
+                                callback(before.getPath(), &before, &changed);
+                            }
+                        }
+                        ++a;
+                        ++b;
+                    }
+                }
+                return changes;
+            }
+
+            bool operator==(const ConfigFlat &other) const {
+                return getSize() == other.getSize() && std::equal(begin(), end(), other.begin());
+            }
+
+            bool operator!=(const ConfigFlat &other) const {
+                return !(*this == other);
+            }
+
+            /**
+             * Builds a document from the entries.
+             * Numeric lists are packed like the parser does.
+             */
+            std::shared_ptr<ConfigObject> unflatten() const {
+                std::shared_ptr<ConfigObject> root;
+                for (auto entry : *this) {
+                    insert(root, entry);
+                }
+                if (!root) {
+                    return std::make_shared<ConfigObject>(SECTION, std::make_shared<ConfigSection>());
+                }
+                return pack(root);
+            }
+        private:
+            std::string_view pathOf(const ConfigFlatRecord &record) const {
+                return std::string_view(buffer.data() + record.path, record.pathLength);
+            }
+
+            std::vector<ConfigFlatRecord>::const_iterator lowerBound(std::string_view path) const {
+                return std::lower_bound(records.begin(), records.end(), path,
+                        [this](const ConfigFlatRecord &record, std::string_view path) {
+                            return pathOf(record) < path;
+                        });
+            }
+
+            void flatten(const ConfigObject &object, std::string &path) {
+                size_t length = path.size();
+                if (object.isSection()) {
+                    auto &section = *object.castTo<const std::shared_ptr<ConfigSection>&>();
+                    if (section.empty()) {
+                        add(path, SECTION);
+                    }
+                    for (auto &entry : section) {
+                        appendKey(path, entry.first.str());
+                        flatten(*entry.second, path);
+                        path.resize(length);
+                    }
+                } else if (object.getPackedType() == NUMBER) {
+                    auto values = object.toNumberSpan();
+                    for (size_t i = 0; i < values.size(); i++) {
+                        appendIndex(path, i);
+                        add(path, NUMBER).number = values[i];
+                        path.resize(length);
+                    }
+                } else if (object.getPackedType() == REAL) {
+                    auto values = object.toRealSpan();
+                    for (size_t i = 0; i < values.size(); i++) {
+                        appendIndex(path, i);
+                        add(path, REAL).real = values[i];
+                        path.resize(length);
+                    }
+                } else if (object.isList()) {
+                    auto &elements = *object.castTo<const std::shared_ptr<ConfigList>&>();
+                    if (elements.empty()) {
+                        add(path, LIST);
+                    }
+                    for (size_t i = 0; i < elements.size(); i++) {
+                        appendIndex(path, i);
+                        flatten(*elements[i], path);
+                        path.resize(length);
+                    }
+                } else {
+                    auto &record = add(path, object.getType());
+                    switch (object.getType()) {
+                        case NUMBER:
+                            record.number = object.toNumber();
+                            break;
+                        case REAL:
+                            record.real = object.toReal();
+                            break;
+                        case BOOLEAN:
+                            record.flag = object.toBool();
+                            break;
+                        case STRING:
+                            record.text = buffer.size();
+                            record.textLength = object.toString().size();
+                            buffer += object.toString();
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+
+            ConfigFlatRecord& add(const std::string &path, ObjectType type) {
+                ConfigFlatRecord record;
+                record.path = buffer.size();
+                record.pathLength = path.size();
+                record.type = type;
+                record.text = 0;
+                record.textLength = 0;
+                buffer += path;
+                records.push_back(record);
+                return records.back();
+            }
+
+            static bool isName(char c) {
+                return isalnum((unsigned char)c) || c == '_' || c == ':' || c == '-';
+            }
+
+            static void appendKey(std::string &path, const std::string &key) {
+                if (!key.empty() && std::all_of(key.begin(), key.end(), isName)) {
+                    if (!path.empty()) {
+                        path += '.';
+                    }
+                    path += key;
+                    return;
+                }
+                path += "['";
+                for (auto c : key) {
+                    if (c == '\'' || c == '\\') {
+                        path += '\\';
+                    }
+                    path += c;
+                }
+                path += "']";
+            }
+
+            static void appendIndex(std::string &path, size_t index) {
+                path += '[';
+                path += std::to_string(index);
+                path += ']';
+            }
+
+            /**
+             * Creates the containers on the path of entry
+             */
+            static void insert(std::shared_ptr<ConfigObject> &root, const ConfigFlatEntry &entry) {
+                auto path = entry.getPath();
+                std::shared_ptr<ConfigObject> *slot = &root;
+                size_t position = 0;
+                std::string key;
+                while (position < path.size()) {
+                    bool isIndex = path[position] == '[' && position + 1 < path.size() && path[position+1] != '\'';
+                    if (!*slot) {
+                        *slot = isIndex ? std::make_shared<ConfigObject>(LIST, std::make_shared<ConfigList>())
+                            : std::make_shared<ConfigObject>(SECTION, std::make_shared<ConfigSection>());
+                    }
+
+                    if (isIndex) {
+                        size_t end = path.find(']', position);
+                        size_t index = std::stoul(std::string(path.substr(position + 1, end - position - 1)));
+                        auto list = (*slot)->toList();
+                        if (list->size() <= index) {
+                            list->resize(index + 1);
+                        }
+                        slot = &(*list)[index];
+                        position = end + 1;
+                        continue;
+                    }
+
+                    key.clear();
+                    if (path[position] == '[') {
+                        // ['key']
+                        position += 2;
+                        while (path[position] != '\'') {
+                            if (path[position] == '\\') {
+                                position++;
+                            }
+                            key += path[position++];
+                        }
+                        position += 2;
+                    } else {
+                        if (path[position] == '.') {
+                            position++;
+                        }
+                        while (position < path.size() && isName(path[position])) {
+                            key += path[position++];
+                        }
+                    }
+                    slot = &(*(*slot)->toSection())[ConfigKey(key)];
+                }
+
+                if (!*slot) {
+                    *slot = entry.toObject();
+                }
+            }
+
+            /**
+             * Replaces homogeneous numeric lists with packed lists
+             */
+            static std::shared_ptr<ConfigObject> pack(const std::shared_ptr<ConfigObject> &object) {
+                if (object->isSection()) {
+                    for (auto &entry : *object->toSection()) {
+                        entry.second = pack(entry.second);
+                    }
+                } else if (object->isList() && !object->isPacked()) {
+                    auto list = object->toList();
+                    if (list->empty()) {
+                        return object;
+                    }
+
+                    ObjectType type = list->front()->getType();
+                    bool homogeneous = type == NUMBER || type == REAL;
+                    for (auto &element : *list) {
+                        homogeneous = homogeneous && element->getType() == type;
+                        element = pack(element);
+                    }
+
+                    if (homogeneous && type == NUMBER) {
+                        auto numbers = std::make_shared<ConfigNumberArray>();
+                        for (auto &element : *list) {
+                            numbers->push_back(element->toNumber());
+                        }
+                        return std::make_shared<ConfigObject>(numbers);
+                    } else if (homogeneous) {
+                        auto reals = std::make_shared<ConfigRealArray>();
+                        for (auto &element : *list) {
+                            reals->push_back(element->toReal());
+                        }
+                        return std::make_shared<ConfigObject>(reals);
+                    }
+                }
+                return object;
+            }
+
+            std::string buffer;
+            std::vector<ConfigFlatRecord> records;
+    };
+}
+
+#endif
@@ -0,0 +1,432 @@
+/*
+Copyright 2021 Lukas Krickl (lukas@krickl.dev)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction,
+including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",
+WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CONFIGPARALLEL_H__
+#define __CONFIGPARALLEL_H__
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+
+#include "configcc.h"
+
+namespace liblc {
+    /**
+     * Work stealing thread pool for fork join tasks.
+     * Every worker owns a queue, it runs its newest task first
+     * while idle workers steal the oldest tasks of other queues.
+     * Threads waiting for a task run other tasks in the meantime.
+     */
+    class ConfigTaskPool {
+        public:
+            /**
+             * A task does not own its function,
+             * both have to outlive the wait for the task.
+             */
+            class Task {
+                public:
+                    template<typename F>
+                    Task(F &function):
+                        invoke([](void *function) { (*(F*)function)(); }), function(&function) {}
+                private:
+                    friend class ConfigTaskPool;
+
+                    void (*invoke)(void*);
+                    void *function;
+                    std::atomic<bool> done = false;
+                    std::exception_ptr error;
+            };
+
+            /**
+             * Starts threads workers, threads waiting for tasks work as well.
+             * With 0 workers every task runs on the waiting thread.
+             */
+            ConfigTaskPool(size_t threads=std::max(1u, std::thread::hardware_concurrency()) - 1) {
+                // the last queue is shared by threads outside of the pool
+                for (size_t i = 0; i <= threads; i++) {
+                    queues.push_back(std::make_unique<Queue>());
+                }
+                for (size_t i = 0; i < threads; i++) {
+                    workers.push_back(std::thread(&ConfigTaskPool::work, this, i));
+                }
+            }
+
+            ~ConfigTaskPool() {
+                {
+                    std::lock_guard<std::mutex> lock(sleepMutex);
+                    stop = true;
+                }
+                wake.notify_all();
+                for (auto &worker : workers) {
+                    worker.join();
+                }
+            }
+
+            size_t getWorkers() const {
+                return workers.size();
+            }
+
+            void spawn(Task &task) {
+                auto &queue = *queues[current()];
+                {
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    queue.tasks.push_back(&task);
+                }
+                pending.fetch_add(1, std::memory_order_release);
+                {
+                    // a worker checking for work sees pending before it sleeps
+                    std::lock_guard<std::mutex> lock(sleepMutex);
+                }
+                wake.notify_one();
+            }
+
+            /**
+             * Runs other tasks until task is done.
+             * Throws:
+             *  the exception thrown by task
+             */
+            void wait(Task &task) {
+                size_t index = current();
+                while (!task.done.load(std::memory_order_acquire)) {
+                    auto other = take(index);
+                    if (other) {
+                        execute(other);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                if (task.error) {
+                    std::rethrow_exception(task.error);
+                }
+            }
+        private:
+            struct Queue {
+                std::mutex mutex;
+                std::deque<Task*> tasks;
+            };
+
+            struct Worker {
+                ConfigTaskPool *pool = nullptr;
+                size_t index = 0;
+            };
+
+            static Worker& worker() {
+                thread_local Worker worker;
+                return worker;
+            }
+
+            size_t current() {
+                if (worker().pool == this) {
+                    return worker().index;
+                }
+                return queues.size() - 1;
+            }
+
+            void work(size_t index) {
+                worker().pool = this;
+                worker().index = index;
+                while (true) {
+                    auto task = take(index);
+                    if (task) {
+                        execute(task);
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(sleepMutex);
+                    wake.wait(lock, [this]() {
+                        return stop || pending.load(std::memory_order_acquire) > 0;
+                    });
+                    if (stop) {
+                        return;
+                    }
+                }
+            }
+
+            /**
+             * Returns:
+             *  the newest task of queue index or the oldest task of another queue
+             */
+            Task* take(size_t index) {
+                if (pending.load(std::memory_order_acquire) == 0) {
+                    return nullptr;
+                }
+
+                for (size_t i = 0; i < queues.size(); i++) {
+                    auto &queue = *queues[(index + i) % queues.size()];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    if (queue.tasks.empty()) {
+                        continue;
+                    }
+
+                    Task *task;
+                    if (i == 0) {
+                        task = queue.tasks.back();
+                        queue.tasks.pop_back();
+                    } else {
+                        task = queue.tasks.front();
+                        queue.tasks.pop_front();
+                    }
+                    pending.fetch_sub(1, std::memory_order_relaxed);
+                    return task;
+                }
+                return nullptr;
+            }
+
+            void execute(Task *task) {
+                try {
+                    task->invoke(task->function);
+                } catch (...) {
+                    task->error = std::current_exception();
+                }
+                task->done.store(true, std::memory_order_release);
+            }
+
+            std::vector<std::unique_ptr<Queue>> queues;
+            std::vector<std::thread> workers;
+            std::atomic<size_t> pending = 0;
+            std::mutex sleepMutex;
+            std::condition_variable wake;
+            bool stop = false;
+    };
+
+    /**
+     * Typed visitor for ConfigMapReduce.
+     * Every value is mapped to an R, the results of a subtree are
+     * combined with reduce in document order.
+     * Methods are called from several threads at once.
+     */
+    template<typename R>
+    class ConfigParallelVisitor {
+        public:
+            virtual ~ConfigParallelVisitor() {}
+
+            virtual R visitNil() const {
+                return R();
+            }
+
+            virtual R visitBoolean(ConfigBool value) const {
+                return R();
+            }
+
+            virtual R visitNumber(ConfigNumber value) const {
+                return R();
+            }
+
+            virtual R visitReal(ConfigReal value) const {
+                return R();
+            }
+
+            virtual R visitString(const ConfigString &value) const {
+                return R();
+            }
+
+            /**
+             * Called for a list before its elements,
+             * elements of packed lists are visited as numbers or reals.
+             */
+            virtual R visitList(const ConfigObject &list) const {
+                return R();
+            }
+
+            /**
+             * Called for a section before its entries
+             */
+            virtual R visitSection(const ConfigObject &section) const {
+                return R();
+            }
+
+            /**
+             * Called for every key before its value
+             */
+            virtual R visitKey(const ConfigKey &key) const {
+                return R();
+            }
+
+            /**
+             * Combines the results of a and then b.
+             * Has to be associative with R() as identity.
+             */
+            virtual R reduce(const R &a, const R &b) const = 0;
+    };
+
+    /**
+     * Visits a tree in parallel.
+     * Lists, packed lists and sections are split in halves until a part is
+     * estimated to hold less than grain values, the halves run as tasks.
+     * The result does not depend on the amount of workers.
+     */
+    template<typename R>
+    class ConfigMapReduce {
+        public:
+            ConfigMapReduce(ConfigTaskPool &pool, const ConfigParallelVisitor<R> &visitor, size_t grain=4096):
+                pool(pool), visitor(visitor), grain(std::max((size_t)1, grain)) {}
+
+            /**
+             * Throws:
+             *  the first exception thrown by the visitor
+             */
+            R run(const ConfigObject &root) {
+                return node(root);
+            }
+
+            R run(const std::shared_ptr<const ConfigObject> &root) {
+                return node(*root);
+            }
+        private:
+            typedef ConfigSection::value_type Entry;
+
+            R node(const ConfigObject &object) {
+                switch (object.getType()) {
+                    case BOOLEAN:
+                        return visitor.visitBoolean(object.toBool());
+                    case NUMBER:
+                        return visitor.visitNumber(object.toNumber());
+                    case REAL:
+                        return visitor.visitReal(object.toReal());
+                    case STRING:
+                        return visitor.visitString(object.toString());
+                    case LIST:
+                        return visitor.reduce(visitor.visitList(object), list(object));
+                    case SECTION:
+                        return visitor.reduce(visitor.visitSection(object), section(object));
+                    default:
+                        return visitor.visitNil();
+                }
+            }
+
+            R list(const ConfigObject &object) {
+                if (object.getPackedType() == NUMBER) {
+                    auto values = object.toNumberSpan();
+                    return range(0, values.size(),
+                            [&](size_t i) { return visitor.visitNumber(values[i]); },
+                            [](size_t begin, size_t end) { return end - begin; });
+                } else if (object.getPackedType() == REAL) {
+                    auto values = object.toRealSpan();
+                    return range(0, values.size(),
+                            [&](size_t i) { return visitor.visitReal(values[i]); },
+                            [](size_t begin, size_t end) { return end - begin; });
+                }
+
+                auto &elements = *object.castTo<const std::shared_ptr<ConfigList>&>();
+                return range(0, elements.size(),
+                        [&](size_t i) { return node(*elements[i]); },
+                        [&](size_t begin, size_t end) {
+                            size_t weight = 0;
+                            for (size_t i = begin; i < end; i++) {
+                                weight += 1 + size(*elements[i]);
+                            }
+                            return weight;
+                        });
+            }
+
+            R section(const ConfigObject &object) {
+                auto &section = *object.castTo<const std::shared_ptr<ConfigSection>&>();
+                size_t weight = section.size();
+                for (auto entry = section.begin(); entry != section.end() && weight < grain; entry++) {
+                    weight += size(*entry->second);
+                }
+
+                if (weight < grain || section.size() < 2) {
+                    R result = R();
+                    for (auto &entry : section) {
+                        result = visitor.reduce(result, this->entry(entry));
+                    }
+                    return result;
+                }
+
+                // sections are split by position
+                std::vector<const Entry*> entries;
+                entries.reserve(section.size());
+                for (auto &entry : section) {
+                    entries.push_back(&entry);
+                }
+                return range(0, entries.size(),
+                        [&](size_t i) { return entry(*entries[i]); },
+                        [&](size_t begin, size_t end) {
+                            size_t weight = 0;
+                            for (size_t i = begin; i < end; i++) {
+                                weight += 1 + size(*entries[i]->second);
+                            }
+                            return weight;
+                        });
+            }
+
+            R entry(const Entry &entry) {
+                return visitor.reduce(visitor.visitKey(entry.first), node(*entry.second));
+            }
+
+            /**
+             * Returns:
+             *  the amount of direct children of containers
+             */
+            static size_t size(const ConfigObject &object) {
+                if (object.isList() || object.isSection()) {
+                    return object.getSize();
+                }
+                return 0;
+            }
+
+            template<typename Leaf, typename Weight>
+            R range(size_t begin, size_t end, const Leaf &leaf, const Weight &weight) {
+                if (end - begin > 1 && (end - begin >= grain || weight(begin, end) >= grain)) {
+                    size_t middle = begin + (end - begin) / 2;
+                    R right = R();
+                    auto runRight = [&]() {
+                        right = range(middle, end, leaf, weight);
+                    };
+                    ConfigTaskPool::Task task(runRight);
+                    pool.spawn(task);
+
+                    R left;
+                    try {
+                        left = range(begin, middle, leaf, weight);
+                    } catch (...) {
+                        // the task refers to this frame
+                        try {
+                            pool.wait(task);
+                        } catch (...) {
+                        }
+                        throw;
+                    }
+                    pool.wait(task);
+                    return visitor.reduce(left, right);
+                }
+
+                R result = R();
+                for (size_t i = begin; i < end; i++) {
+                    result = visitor.reduce(result, leaf(i));
+                }
+                return result;
+            }
+
+            ConfigTaskPool &pool;
+            const ConfigParallelVisitor<R> &visitor;
+            size_t grain;
+    };
+}
+
+#endif
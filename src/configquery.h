@@ -0,0 +1,722 @@
+/*
+Copyright 2021 Lukas Krickl (lukas@krickl.dev)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction,
+including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",
+WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CONFIGQUERY_H__
+#define __CONFIGQUERY_H__
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <iterator>
+#include <cstdlib>
+
+#include "configcc.h"
+
+namespace liblc {
+    class ConfigccQueryError: public ConfigparseCommonException {
+        public:
+            ConfigccQueryError(size_t position):
+                ConfigparseCommonException(std::shared_ptr<Token>(nullptr), INVALID_QUERY), position(position) {}
+
+            // offset of the error in the query
+            const size_t position;
+    };
+
+    /**
+     * Non-owning reference to a value selected by a query.
+     * Elements of packed lists are not objects,
+     * they are referenced by their list and index instead.
+     * A match is valid as long as the queried document is.
+     */
+    class ConfigQueryMatch {
+        public:
+            ConfigQueryMatch(const ConfigObject *object=nullptr, const ConfigObject *packed=nullptr, size_t index=0):
+                object(object), packed(packed), index(index) {}
+
+            /**
+             * Returns:
+             *  the matched object or nullptr for elements of packed lists
+             */
+            const ConfigObject* getObject() const {
+                return object;
+            }
+
+            bool isPackedElement() const {
+                return object == nullptr && packed != nullptr;
+            }
+
+            /**
+             * Returns:
+             *  the index of a packed element
+             */
+            size_t getIndex() const {
+                return index;
+            }
+
+            ObjectType getType() const {
+                if (object) {
+                    return object->getType();
+                }
+                return packed->getPackedType();
+            }
+
+            ConfigNumber toNumber() const {
+                if (object) {
+                    return object->toNumber();
+                } else if (packed->getPackedType() == NUMBER) {
+                    return packed->toNumberSpan()[index];
+                }
+                return packed->toRealSpan()[index];
+            }
+
+            ConfigReal toReal() const {
+                if (object) {
+                    return object->toReal();
+                } else if (packed->getPackedType() == NUMBER) {
+                    return packed->toNumberSpan()[index];
+                }
+                return packed->toRealSpan()[index];
+            }
+
+            const ConfigString& toString() const {
+                if (!object) {
+                    throw ConfigccTypeError(STRING);
+                }
+                return object->toString();
+            }
+
+            ConfigBool toBool() const {
+                if (!object) {
+                    throw ConfigccTypeError(BOOLEAN);
+                }
+                return object->toBool();
+            }
+        private:
+            const ConfigObject *object;
+            const ConfigObject *packed;
+            size_t index;
+    };
+
+    class ConfigQueryView;
+
+    /**
+     * Selects values from a document.
+     * A query is a chain of steps:
+     *  name or .name     the value of key name
+     *  ['name']          the value of a quoted key
+     *  .* or [*]         every value of a section or list
+     *  [i]               element i of a list, negative indices count from the end
+     *  [begin:end]       elements begin up to but excluding end, both are optional
+     *  [?key op value]   every value of a section or list that is a section with
+     *                    key op value, op is one of == != < <= > >=
+     *  [?key]            every value that is a section with key
+     *  [?@ op value]     every value of a section or list that satisfies op value
+     *  ..step            step applied to the current value and all of its descendants
+     * Values in predicates are numbers, quoted strings, true, false or nil.
+     * Example: servers[?region == 'eu']..port
+     *
+     * A query is compiled once and keeps its traversal stack between runs,
+     * so running it again does not allocate.
+     * A query can only run one selection at a time, use one query per thread.
+     * Throws:
+     *  ConfigccQueryError if the query is malformed
+     */
+    class ConfigQuery {
+        public:
+            ConfigQuery(const std::string &query):
+                query(query) {
+                compile();
+            }
+
+            /**
+             * Returns:
+             *  a view of all matches in document order,
+             *  the view is invalidated by the next select on this query
+             */
+            ConfigQueryView select(const ConfigObject &root);
+
+            ConfigQueryView select(const std::shared_ptr<ConfigObject> &root);
+
+            /**
+             * Returns:
+             *  the first match
+             * Throws:
+             *  ConfigccKeyNotFound if nothing matches
+             */
+            ConfigQueryMatch first(const ConfigObject &root) {
+                ConfigQueryMatch match;
+                start(root);
+                if (!next(match)) {
+                    throw ConfigccKeyNotFound();
+                }
+                frames.clear();
+                return match;
+            }
+
+            size_t count(const ConfigObject &root) {
+                ConfigQueryMatch match;
+                size_t matches = 0;
+                start(root);
+                while (next(match)) {
+                    matches++;
+                }
+                return matches;
+            }
+
+            const std::string& getQuery() const {
+                return query;
+            }
+
+            /**
+             * Starts a new selection at root
+             */
+            void start(const ConfigObject &root) {
+                frames.clear();
+                frames.push_back(Frame(ConfigQueryMatch(&root), 0));
+            }
+
+            /**
+             * Stores the next match of the current selection in match.
+             * Returns:
+             *  false if there are no more matches
+             */
+            bool next(ConfigQueryMatch &match) {
+                ConfigQueryMatch child;
+                while (!frames.empty()) {
+                    Frame &frame = frames.back();
+                    if (frame.step == steps.size()) {
+                        match = frame.node;
+                        frames.pop_back();
+                        return true;
+                    }
+
+                    size_t step = frame.step;
+                    if (!frame.descending) {
+                        if (select(frame, steps[step], child)) {
+                            frames.push_back(Frame(child, step+1));
+                            continue;
+                        } else if (!steps[step].recursive) {
+                            frames.pop_back();
+                            continue;
+                        }
+                        // the step is then applied to every child
+                        frame.descending = true;
+                        frame.started = false;
+                        frame.index = 0;
+                    }
+
+                    if (nextChild(frame, child)) {
+                        frames.push_back(Frame(child, step));
+                    } else {
+                        frames.pop_back();
+                    }
+                }
+                return false;
+            }
+
+        private:
+            enum StepType {
+                STEP_KEY,
+                STEP_ANY,
+                STEP_RANGE,
+                STEP_FILTER
+            };
+
+            enum Operator {
+                OP_EXISTS,
+                OP_EQUAL,
+                OP_NOT_EQUAL,
+                OP_LESS,
+                OP_LESS_EQUAL,
+                OP_GREATER,
+                OP_GREATER_EQUAL
+            };
+
+            struct Step {
+                StepType type;
+                bool recursive = false;
+                // key of STEP_KEY and STEP_FILTER, empty filters test the value itself
+                std::string key;
+                long begin = 0;
+                long end = 0;
+                bool hasEnd = false;
+                Operator op = OP_EXISTS;
+                ObjectType literalType = NIL;
+                double number = 0;
+                std::string text;
+                bool flag = false;
+            };
+
+            struct Frame {
+                Frame(ConfigQueryMatch node, size_t step):
+                    node(node), step(step) {}
+
+                ConfigQueryMatch node;
+                size_t step;
+                // visits children to apply a recursive step to them
+                bool descending = false;
+                bool started = false;
+                size_t index = 0;
+                size_t end = 0;
+                ConfigSection::const_iterator entry;
+            };
+
+            static const ConfigSection& sectionOf(const ConfigObject *node) {
+                return *node->castTo<const std::shared_ptr<ConfigSection>&>();
+            }
+
+            static size_t sizeOf(const ConfigObject *node) {
+                if (node->isPacked()) {
+                    return node->getSize();
+                }
+                return node->castTo<const std::shared_ptr<ConfigList>&>()->size();
+            }
+
+            static ConfigQueryMatch element(const ConfigObject *node, size_t index) {
+                if (node->isPacked()) {
+                    return ConfigQueryMatch(nullptr, node, index);
+                }
+                return ConfigQueryMatch((*node->castTo<const std::shared_ptr<ConfigList>&>())[index].get());
+            }
+
+            /**
+             * Visits every value of a section or list
+             */
+            bool nextChild(Frame &frame, ConfigQueryMatch &child) {
+                auto node = frame.node.getObject();
+                if (!node) {
+                    return false;
+                } else if (node->isSection()) {
+                    auto &section = sectionOf(node);
+                    if (!frame.started) {
+                        frame.entry = section.begin();
+                        frame.started = true;
+                    }
+                    if (frame.entry == section.end()) {
+                        return false;
+                    }
+                    child = ConfigQueryMatch(frame.entry->second.get());
+                    ++frame.entry;
+                    return true;
+                } else if (node->isList() && frame.index < sizeOf(node)) {
+                    child = element(node, frame.index++);
+                    return true;
+                }
+                return false;
+            }
+
+            bool select(Frame &frame, const Step &step, ConfigQueryMatch &child) {
+                auto node = frame.node.getObject();
+                switch (step.type) {
+                    case STEP_KEY:
+                        if (frame.started || !node || !node->isSection()) {
+                            return false;
+                        } else {
+                            frame.started = true;
+                            auto &section = sectionOf(node);
+                            auto found = section.find(step.key);
+                            if (found == section.end()) {
+                                return false;
+                            }
+                            child = ConfigQueryMatch(found->second.get());
+                            return true;
+                        }
+                    case STEP_ANY:
+                        return nextChild(frame, child);
+                    case STEP_RANGE:
+                        if (!node || !node->isList()) {
+                            return false;
+                        }
+                        if (!frame.started) {
+                            long size = sizeOf(node);
+                            frame.index = clamp(step.begin, size);
+                            frame.end = step.hasEnd ? clamp(step.end, size) : size;
+                            frame.started = true;
+                        }
+                        if (frame.index >= frame.end) {
+                            return false;
+                        }
+                        child = element(node, frame.index++);
+                        return true;
+                    case STEP_FILTER:
+                        while (nextChild(frame, child)) {
+                            if (test(step, child)) {
+                                return true;
+                            }
+                        }
+                        return false;
+                }
+                return false;
+            }
+
+            static size_t clamp(long index, long size) {
+                if (index < 0) {
+                    index += size;
+                }
+                return std::max(0l, std::min(index, size));
+            }
+
+            bool test(const Step &step, const ConfigQueryMatch &candidate) {
+                ConfigQueryMatch value = candidate;
+                if (!step.key.empty()) {
+                    auto node = candidate.getObject();
+                    if (!node || !node->isSection()) {
+                        return false;
+                    }
+                    auto &section = sectionOf(node);
+                    auto found = section.find(step.key);
+                    if (found == section.end()) {
+                        return false;
+                    }
+                    value = ConfigQueryMatch(found->second.get());
+                }
+
+                if (step.op == OP_EXISTS) {
+                    return true;
+                }
+
+                auto type = value.getType();
+                int order = 0;
+                bool ordered = true;
+                if ((type == NUMBER || type == REAL) && (step.literalType == NUMBER || step.literalType == REAL)) {
+                    // compare reals at their own precision
+                    double a = type == REAL ? (double)value.toReal() : (double)value.toNumber();
+                    double b = type == REAL ? (double)(ConfigReal)step.number : step.number;
+                    order = a < b ? -1 : (a > b ? 1 : 0);
+                } else if (type == STRING && step.literalType == STRING) {
+                    order = value.toString().compare(step.text);
+                } else if (type == BOOLEAN && step.literalType == BOOLEAN) {
+                    order = value.toBool() == step.flag ? 0 : 1;
+                    ordered = false;
+                } else if (type == NIL && step.literalType == NIL) {
+                    ordered = false;
+                } else {
+                    // values of different types are never equal
+                    return step.op == OP_NOT_EQUAL;
+                }
+
+                switch (step.op) {
+                    case OP_EQUAL:
+                        return order == 0;
+                    case OP_NOT_EQUAL:
+                        return order != 0;
+                    case OP_LESS:
+                        return ordered && order < 0;
+                    case OP_LESS_EQUAL:
+                        return ordered && order <= 0;
+                    case OP_GREATER:
+                        return ordered && order > 0;
+                    case OP_GREATER_EQUAL:
+                        return ordered && order >= 0;
+                    default:
+                        return true;
+                }
+            }
+
+            void compile() {
+                position = 0;
+                // the first step does not need a .
+                if (!isAtEnd() && isName(peek())) {
+                    steps.push_back(keyStep(name()));
+                } else if (match('*')) {
+                    steps.push_back(Step { STEP_ANY });
+                }
+
+                while (!isAtEnd()) {
+                    bool recursive = false;
+                    if (match('.')) {
+                        recursive = match('.');
+                        if (match('*')) {
+                            steps.push_back(Step { STEP_ANY });
+                        } else if (!isAtEnd() && isName(peek())) {
+                            steps.push_back(keyStep(name()));
+                        } else if (recursive && peek() == '[') {
+                            steps.push_back(bracket());
+                        } else {
+                            throw ConfigccQueryError(position);
+                        }
+                    } else if (peek() == '[') {
+                        steps.push_back(bracket());
+                    } else {
+                        throw ConfigccQueryError(position);
+                    }
+                    steps.back().recursive = recursive;
+                }
+            }
+
+            Step keyStep(const std::string &key) {
+                Step step { STEP_KEY };
+                step.key = key;
+                return step;
+            }
+
+            Step bracket() {
+                expect('[');
+                skipSpace();
+                Step step { STEP_RANGE };
+                if (match('*')) {
+                    step.type = STEP_ANY;
+                } else if (peek() == '\'' || peek() == '"') {
+                    step = keyStep(string());
+                } else if (match('?')) {
+                    step.type = STEP_FILTER;
+                    filter(step);
+                } else {
+                    bool slice = false;
+                    if (peek() != ':') {
+                        step.begin = integer();
+                    }
+                    skipSpace();
+                    if (match(':')) {
+                        slice = true;
+                        skipSpace();
+                        if (peek() != ']') {
+                            step.end = integer();
+                            step.hasEnd = true;
+                        }
+                    }
+                    if (!slice) {
+                        // a single index, -1 has to end at the size of the list
+                        step.end = step.begin + 1;
+                        step.hasEnd = step.end != 0;
+                    }
+                }
+                skipSpace();
+                expect(']');
+                return step;
+            }
+
+            void filter(Step &step) {
+                skipSpace();
+                if (!match('@')) {
+                    if (peek() == '\'' || peek() == '"') {
+                        step.key = string();
+                    } else {
+                        step.key = name();
+                    }
+                }
+                skipSpace();
+                if (peek() == ']') {
+                    if (step.key.empty()) {
+                        throw ConfigccQueryError(position);
+                    }
+                    return;
+                }
+
+                if (match('=')) {
+                    expect('=');
+                    step.op = OP_EQUAL;
+                } else if (match('!')) {
+                    expect('=');
+                    step.op = OP_NOT_EQUAL;
+                } else if (match('<')) {
+                    step.op = match('=') ? OP_LESS_EQUAL : OP_LESS;
+                } else if (match('>')) {
+                    step.op = match('=') ? OP_GREATER_EQUAL : OP_GREATER;
+                } else {
+                    throw ConfigccQueryError(position);
+                }
+                skipSpace();
+                literal(step);
+            }
+
+            void literal(Step &step) {
+                if (peek() == '\'' || peek() == '"') {
+                    step.literalType = STRING;
+                    step.text = string();
+                } else if (peek() == '-' || peek() == '+' || isdigit(peek())) {
+                    const char *begin = query.c_str() + position;
+                    char *end = nullptr;
+                    step.number = strtod(begin, &end);
+                    if (end == begin) {
+                        throw ConfigccQueryError(position);
+                    }
+                    step.literalType = NUMBER;
+                    position += end - begin;
+                } else {
+                    size_t begin = position;
+                    auto word = name();
+                    if (word == "true" || word == "false") {
+                        step.literalType = BOOLEAN;
+                        step.flag = word == "true";
+                    } else if (word == "nil") {
+                        step.literalType = NIL;
+                    } else {
+                        throw ConfigccQueryError(begin);
+                    }
+                }
+            }
+
+            long integer() {
+                const char *begin = query.c_str() + position;
+                char *end = nullptr;
+                long value = strtol(begin, &end, 10);
+                if (end == begin) {
+                    throw ConfigccQueryError(position);
+                }
+                position += end - begin;
+                return value;
+            }
+
+            std::string string() {
+                char quote = query[position++];
+                std::string value;
+                while (!isAtEnd() && peek() != quote) {
+                    if (peek() == '\\') {
+                        position++;
+                        if (isAtEnd()) {
+                            break;
+                        }
+                    }
+                    value += query[position++];
+                }
+                expect(quote);
+                return value;
+            }
+
+            std::string name() {
+                size_t begin = position;
+                while (!isAtEnd() && isName(peek())) {
+                    position++;
+                }
+                if (begin == position) {
+                    throw ConfigccQueryError(position);
+                }
+                return query.substr(begin, position-begin);
+            }
+
+            static bool isName(char c) {
+                return isalnum((unsigned char)c) || c == '_' || c == ':' || c == '-';
+            }
+
+            void skipSpace() {
+                while (!isAtEnd() && peek() == ' ') {
+                    position++;
+                }
+            }
+
+            bool isAtEnd() {
+                return position >= query.size();
+            }
+
+            char peek() {
+                return isAtEnd() ? '\0' : query[position];
+            }
+
+            bool match(char c) {
+                if (peek() != c || isAtEnd()) {
+                    return false;
+                }
+                position++;
+                return true;
+            }
+
+            void expect(char c) {
+                if (!match(c)) {
+                    throw ConfigccQueryError(position);
+                }
+            }
+
+            std::string query;
+            size_t position = 0;
+            std::vector<Step> steps;
+            std::vector<Frame> frames;
+    };
+
+    /**
+     * Iterates the matches of a running query.
+     */
+    class ConfigQueryIterator {
+        public:
+            typedef std::input_iterator_tag iterator_category;
+            typedef ConfigQueryMatch value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const ConfigQueryMatch* pointer;
+            typedef const ConfigQueryMatch& reference;
+
+            ConfigQueryIterator(ConfigQuery *query=nullptr):
+                query(query) {
+                advance();
+            }
+
+            reference operator*() const {
+                return current;
+            }
+
+            pointer operator->() const {
+                return &current;
+            }
+
+            ConfigQueryIterator& operator++() {
+                advance();
+                return *this;
+            }
+
+            bool operator==(const ConfigQueryIterator &other) const {
+                return query == other.query;
+            }
+
+            bool operator!=(const ConfigQueryIterator &other) const {
+                return query != other.query;
+            }
+        private:
+            void advance() {
+                if (query && !query->next(current)) {
+                    query = nullptr;
+                }
+            }
+
+            ConfigQuery *query;
+            ConfigQueryMatch current;
+    };
+
+    /**
+     * Matches of a query, iterating starts the selection.
+     */
+    class ConfigQueryView {
+        public:
+            ConfigQueryView(ConfigQuery *query, const ConfigObject *root):
+                query(query), root(root) {}
+
+            ConfigQueryIterator begin() {
+                query->start(*root);
+                return ConfigQueryIterator(query);
+            }
+
+            ConfigQueryIterator end() {
+                return ConfigQueryIterator();
+            }
+        private:
+            ConfigQuery *query;
+            const ConfigObject *root;
+    };
+
+    inline ConfigQueryView ConfigQuery::select(const ConfigObject &root) {
+        return ConfigQueryView(this, &root);
+    }
+
+    inline ConfigQueryView ConfigQuery::select(const std::shared_ptr<ConfigObject> &root) {
+        return ConfigQueryView(this, root.get());
+    }
+}
+
+#endif
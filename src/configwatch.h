@@ -0,0 +1,278 @@
+/*
+Copyright 2021 Lukas Krickl (lukas@krickl.dev)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction,
+including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",
+WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CONFIGWATCH_H__
+#define __CONFIGWATCH_H__
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <set>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <exception>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+
+#include "configcc.h"
+
+namespace liblc {
+    class ConfigWatchError: public std::exception {
+        public:
+            ConfigWatchError(std::string text): text(text) {}
+            virtual const char* what() const throw() {
+                return text.c_str();
+            }
+        private:
+            std::string text;
+    };
+
+    /**
+     * Receives reloads from ConfigWatcher.
+     * All calls are made from the watcher's thread.
+     */
+    class ConfigWatchHandler {
+        public:
+            ConfigWatchHandler() {}
+            virtual ~ConfigWatchHandler() {}
+
+            virtual void onReload(const std::string &path, std::shared_ptr<ConfigObject> root) {}
+
+            // error->token contains path and line
+            virtual void onError(const std::string &path, const ConfigparseCommonException &error) {}
+
+            /**
+             * Called with exceptions thrown by onReload or onError,
+             * the watcher keeps running afterwards.
+             * Errors of the watcher itself are reported with an empty path,
+             * the watcher stops after them.
+             */
+            virtual void onException(const std::string &path, std::exception_ptr error) {}
+    };
+
+    /**
+     * Watches config files with inotify and reparses them on a background thread.
+     * Bursts of writes are merged into one reload after debounce,
+     * files whose content did not change are not parsed again.
+     * The parent directory of each file is watched so files replaced by rename are picked up.
+     */
+    class ConfigWatcher {
+        public:
+            ConfigWatcher(ConfigWatchHandler *handler, std::chrono::milliseconds debounce=std::chrono::milliseconds(50)):
+                handler(handler), debounce(debounce) {
+                inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                if (inotifyFd < 0) {
+                    throw ConfigWatchError("Unable to initialize inotify");
+                }
+                stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (stopFd < 0) {
+                    close(inotifyFd);
+                    throw ConfigWatchError("Unable to create eventfd");
+                }
+            }
+
+            ConfigWatcher(const ConfigWatcher&) = delete;
+            ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+            ~ConfigWatcher() {
+                stop();
+                close(inotifyFd);
+                close(stopFd);
+            }
+
+            /**
+             * Adds a file to the watch list.
+             * Must be called before start.
+             */
+            void addPath(std::string path) {
+                auto split = path.find_last_of('/');
+                std::string dir = split == std::string::npos ? "." : path.substr(0, split);
+                std::string name = split == std::string::npos ? path : path.substr(split+1);
+                if (dir == "") {
+                    dir = "/";
+                }
+
+                int wd = inotify_add_watch(inotifyFd, dir.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY);
+                if (wd < 0) {
+                    throw ConfigWatchError("Unable to watch " + dir);
+                }
+                files[std::make_pair(wd, name)] = path;
+            }
+
+            /**
+             * Starts watching, every file is parsed once on the watcher's thread first.
+             */
+            void start() {
+                if (thread.joinable()) {
+                    return;
+                }
+                thread = std::thread(&ConfigWatcher::run, this);
+            }
+
+            /**
+             * Stops watching, start may be called again afterwards.
+             */
+            void stop() {
+                if (!thread.joinable()) {
+                    return;
+                }
+                uint64_t value = 1;
+                if (write(stopFd, &value, sizeof(value)) != sizeof(value)) {
+                    // eventfd writes only fail on overflow
+                }
+                thread.join();
+
+                // reset the eventfd so the next run does not stop right away
+                if (read(stopFd, &value, sizeof(value)) != sizeof(value)) {
+                    // already drained
+                }
+            }
+        private:
+            typedef std::chrono::steady_clock Clock;
+
+            void run() {
+                for (auto it = files.begin(); it != files.end(); it++) {
+                    reload(it->second);
+                }
+
+                std::map<std::string, Clock::time_point> pending;
+                pollfd fds[2] = {
+                    { inotifyFd, POLLIN, 0 },
+                    { stopFd, POLLIN, 0 }
+                };
+
+                while (true) {
+                    // sleep forever unless a reload is pending
+                    int timeout = -1;
+                    if (!pending.empty()) {
+                        timeout = debounce.count();
+                    }
+
+                    if (poll(fds, 2, timeout) < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        // retrying would not succeed either
+                        report("", std::make_exception_ptr(
+                                    ConfigWatchError(std::string("Unable to poll: ") + strerror(errno))));
+                        return;
+                    }
+
+                    if (fds[1].revents & POLLIN) {
+                        return;
+                    }
+
+                    if (fds[0].revents & POLLIN) {
+                        readEvents(pending);
+                    }
+
+                    // reload files that were quiet for debounce
+                    auto now = Clock::now();
+                    for (auto it = pending.begin(); it != pending.end();) {
+                        if (now - it->second >= debounce) {
+                            reload(it->first);
+                            it = pending.erase(it);
+                        } else {
+                            it++;
+                        }
+                    }
+                }
+            }
+
+            void readEvents(std::map<std::string, Clock::time_point> &pending) {
+                alignas(inotify_event) char buffer[4096];
+                ssize_t length;
+                while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+                    for (char *ptr = buffer; ptr < buffer + length;) {
+                        auto event = (inotify_event*)ptr;
+                        if (event->len > 0) {
+                            auto found = files.find(std::make_pair(event->wd, std::string(event->name)));
+                            if (found != files.end()) {
+                                pending[found->second] = Clock::now();
+                            }
+                        }
+                        ptr += sizeof(inotify_event) + event->len;
+                    }
+                }
+            }
+
+            void reload(const std::string &path) {
+                std::ifstream file(path);
+                if (!file) {
+                    // file is gone, wait for it to come back
+                    return;
+                }
+                std::stringstream content;
+                content << file.rdbuf();
+                std::string data = content.str();
+
+                size_t hash = std::hash<std::string>()(data);
+                auto last = hashes.find(path);
+                if (last != hashes.end() && last->second == hash) {
+                    return;
+                }
+                hashes[path] = hash;
+
+                try {
+                    std::shared_ptr<ConfigObject> root;
+                    try {
+                        ConfigParser parser(data, path);
+                        root = parser.parse();
+                    } catch (ConfigparseCommonException &e) {
+                        handler->onError(path, e);
+                        return;
+                    }
+                    handler->onReload(path, root);
+                } catch (...) {
+                    report(path, std::current_exception());
+                }
+            }
+
+            // exceptions must not leave the watcher's thread
+            void report(const std::string &path, std::exception_ptr error) {
+                try {
+                    handler->onException(path, error);
+                } catch (...) {
+                }
+            }
+
+            ConfigWatchHandler *handler;
+            std::chrono::milliseconds debounce;
+            int inotifyFd;
+            int stopFd;
+            std::thread thread;
+
+            // (watch descriptor, file name) -> path
+            std::map<std::pair<int, std::string>, std::string> files;
+            std::map<std::string, size_t> hashes;
+    };
+}
+
+#endif
@@ -56,6 +56,55 @@ namespace liblc {
 
         return strstream.str();
     }
+
+    /**
+     * Inverse of unescape. Appends the escaped src to out.
+     */
+    inline void escape(const std::string &src, std::string &out) {
+        for (char c : src) {
+            switch (c) {
+                case '\a':
+                    out += "\\a";
+                    break;
+                case '\b':
+                    out += "\\b";
+                    break;
+                case '\r':
+                    out += "\\r";
+                    break;
+                case '\t':
+                    out += "\\t";
+                    break;
+                case '\v':
+                    out += "\\v";
+                    break;
+                case '\n':
+                    out += "\\n";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\'':
+                    out += "\\'";
+                    break;
+                case '\0':
+                    out += "\\0";
+                    break;
+                default:
+                    out += c;
+                    break;
+            }
+        }
+    }
+
+    inline std::string escape(const std::string &src) {
+        std::string out;
+        escape(src, out);
+        return out;
+    }
 }
 
 #endif 
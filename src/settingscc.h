@@ -0,0 +1,365 @@
+/*
+Copyright 2021 Lukas Krickl (lukas@krickl.dev)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction,
+including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",
+WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __SETTINGSCC_H__
+#define __SETTINGSCC_H__
+
+#include <iostream>
+#include <map>
+#include <exception>
+#include <vector>
+#include <memory>
+#include <variant>
+#include <sstream>
+#include <cstdlib>
+#include <limits>
+
+#include "argcc.h"
+#include "configcc.h"
+#include "liblc_typedefs.h"
+
+namespace liblc {
+    // a resolved setting value. nullptr means nil
+    typedef std::variant<std::nullptr_t, ConfigBool, ConfigNumber, ConfigReal, ConfigString> SettingValue;
+
+    enum SettingSource {
+        SETTING_DEFAULT,
+        SETTING_CONFIG,
+        SETTING_ENV,
+        SETTING_ARGV
+    };
+
+    class SettingsTypeException: public std::exception {
+        public:
+            SettingsTypeException(std::string name): text("Unexpected type for setting " + name) {}
+            virtual const char* what() const throw() {
+                return text.c_str();
+            }
+        private:
+            std::string text;
+    };
+
+    class SettingsUnknownSetting: public std::exception {
+        public:
+            SettingsUnknownSetting(std::string name): text("Unknown setting " + name) {}
+            virtual const char* what() const throw() {
+                return text.c_str();
+            }
+        private:
+            std::string text;
+    };
+
+    class SettingDefinition {
+        public:
+            SettingDefinition(std::string name, ObjectType type, SettingValue defaultValue,
+                    std::string env, std::string configPath, std::string argName):
+                name(name), type(type), defaultValue(defaultValue), env(env),
+                configPath(configPath), argName(argName) {}
+
+            const std::string name;
+            const ObjectType type;
+            const SettingValue defaultValue;
+            const std::string env;
+            // dotted path into the config e.g. server.ports.0
+            const std::string configPath;
+            const std::string argName;
+    };
+
+    /**
+     * Describes every setting once.
+     * addSetting returns the id used to read the resolved value.
+     */
+    class SettingsSchema {
+        public:
+            /**
+             * Throws:
+             *  SettingsTypeException if defaultValue is neither nil nor of type
+             */
+            size_t addSetting(std::string name, ObjectType type, SettingValue defaultValue=nullptr,
+                    std::string env="", std::string configPath="", std::string argName="") {
+                if (!matches(type, defaultValue)) {
+                    throw SettingsTypeException(name);
+                }
+                if (argName == "") {
+                    argName = name;
+                }
+                ids[name] = definitions.size();
+                definitions.push_back(SettingDefinition(name, type, defaultValue, env, configPath, argName));
+                return definitions.size()-1;
+            }
+
+            size_t indexOf(std::string name) const {
+                auto found = ids.find(name);
+                if (found == ids.end()) {
+                    throw SettingsUnknownSetting(name);
+                }
+                return found->second;
+            }
+
+            const std::vector<SettingDefinition>& getDefinitions() const {
+                return definitions;
+            }
+        private:
+            static bool matches(ObjectType type, const SettingValue &value) {
+                switch (type) {
+                    case BOOLEAN:
+                        return std::holds_alternative<ConfigBool>(value) || std::holds_alternative<std::nullptr_t>(value);
+                    case NUMBER:
+                        return std::holds_alternative<ConfigNumber>(value) || std::holds_alternative<std::nullptr_t>(value);
+                    case REAL:
+                        return std::holds_alternative<ConfigReal>(value) || std::holds_alternative<std::nullptr_t>(value);
+                    case STRING:
+                        return std::holds_alternative<ConfigString>(value) || std::holds_alternative<std::nullptr_t>(value);
+                    default:
+                        return std::holds_alternative<std::nullptr_t>(value);
+                }
+            }
+
+            std::vector<SettingDefinition> definitions;
+            std::map<std::string, size_t> ids;
+    };
+
+    /**
+     * Immutable flat snapshot of resolved settings.
+     * Reads are plain vector accesses and are safe from any thread.
+     */
+    class Settings {
+        public:
+            Settings(std::vector<SettingValue> values, std::vector<SettingSource> sources,
+                    std::shared_ptr<const SettingsSchema> schema=std::shared_ptr<const SettingsSchema>(nullptr)):
+                values(values), sources(sources), schema(schema) {}
+
+            const SettingValue& get(size_t id) const {
+                return values.at(id);
+            }
+
+            ConfigNumber toNumber(size_t id) const {
+                return getGeneric<ConfigNumber>(id);
+            }
+
+            ConfigReal toReal(size_t id) const {
+                return getGeneric<ConfigReal>(id);
+            }
+
+            ConfigBool toBool(size_t id) const {
+                return getGeneric<ConfigBool>(id);
+            }
+
+            const ConfigString& toString(size_t id) const {
+                return getGeneric<ConfigString>(id);
+            }
+
+            bool isNil(size_t id) const {
+                return std::holds_alternative<std::nullptr_t>(values.at(id));
+            }
+
+            SettingSource getSource(size_t id) const {
+                return sources.at(id);
+            }
+
+            size_t getSize() const {
+                return values.size();
+            }
+        private:
+            template<typename T>
+            const T& getGeneric(size_t id) const {
+                auto value = std::get_if<T>(&values.at(id));
+                if (!value) {
+                    throw SettingsTypeException(getName(id));
+                }
+                return *value;
+            }
+
+            std::string getName(size_t id) const {
+                if (schema && id < schema->getDefinitions().size()) {
+                    return schema->getDefinitions()[id].name;
+                }
+                return std::to_string(id);
+            }
+
+            const std::vector<SettingValue> values;
+            const std::vector<SettingSource> sources;
+            const std::shared_ptr<const SettingsSchema> schema;
+    };
+
+    /**
+     * Resolves every setting in schema in one pass.
+     * Priority is argv > env > config > default.
+     */
+    class SettingsResolver {
+        public:
+            SettingsResolver(std::shared_ptr<const SettingsSchema> schema):
+                schema(schema) {}
+
+            std::shared_ptr<const Settings> resolve(Args *args,
+                    std::shared_ptr<ConfigObject> config=std::shared_ptr<ConfigObject>(nullptr)) {
+                auto &definitions = schema->getDefinitions();
+                std::vector<SettingValue> values;
+                std::vector<SettingSource> sources;
+                values.reserve(definitions.size());
+                sources.reserve(definitions.size());
+
+                for (auto &definition : definitions) {
+                    std::shared_ptr<ConfigObject> configValue;
+                    const char *envValue = nullptr;
+
+                    if (args && args->containsAny(definition.argName)) {
+                        values.push_back(fromArgs(definition, args));
+                        sources.push_back(SETTING_ARGV);
+                    } else if (definition.env != "" && (envValue = std::getenv(definition.env.c_str()))) {
+                        values.push_back(fromString(definition, envValue));
+                        sources.push_back(SETTING_ENV);
+                    } else if ((configValue = findConfig(definition, config)).get()) {
+                        values.push_back(fromConfig(definition, configValue));
+                        sources.push_back(SETTING_CONFIG);
+                    } else {
+                        values.push_back(definition.defaultValue);
+                        sources.push_back(SETTING_DEFAULT);
+                    }
+                }
+
+                return std::make_shared<const Settings>(values, sources, schema);
+            }
+        private:
+            SettingValue fromArgs(const SettingDefinition &definition, Args *args) {
+                try {
+                    switch (definition.type) {
+                        case BOOLEAN:
+                            return args->toBool(definition.argName);
+                        case NUMBER:
+                            return args->toNumber(definition.argName);
+                        case REAL:
+                            return args->toReal(definition.argName);
+                        case STRING:
+                            return args->toString(definition.argName);
+                        default:
+                            break;
+                    }
+                } catch (ArgparseTypeException &e) {
+                    // fall through to type error
+                }
+                throw SettingsTypeException(definition.name);
+            }
+
+            SettingValue fromString(const SettingDefinition &definition, std::string value) {
+                try {
+                    switch (definition.type) {
+                        case BOOLEAN:
+                            if (value == "true" || value == "1") {
+                                return true;
+                            } else if (value == "false" || value == "0") {
+                                return false;
+                            }
+                            break;
+                        case NUMBER: {
+                            // the whole value has to be a number that fits
+                            size_t end = 0;
+                            long number = std::stol(value, &end, 0);
+                            if (end == value.size() && number >= std::numeric_limits<ConfigNumber>::min()
+                                    && number <= std::numeric_limits<ConfigNumber>::max()) {
+                                return (ConfigNumber)number;
+                            }
+                            break;
+                        }
+                        case REAL: {
+                            size_t end = 0;
+                            ConfigReal real = std::stof(value, &end);
+                            if (end == value.size()) {
+                                return real;
+                            }
+                            break;
+                        }
+                        case STRING:
+                            return value;
+                        case NIL:
+                            return nullptr;
+                        default:
+                            break;
+                    }
+                } catch (std::logic_error &e) {
+                    // invalid_argument or out_of_range
+                }
+                throw SettingsTypeException(definition.name);
+            }
+
+            SettingValue fromConfig(const SettingDefinition &definition, std::shared_ptr<ConfigObject> value) {
+                if (value->isNil()) {
+                    return nullptr;
+                }
+
+                switch (definition.type) {
+                    case BOOLEAN:
+                        if (value->isBool()) {
+                            return value->toBool();
+                        }
+                        break;
+                    case NUMBER:
+                        // reals are not truncated
+                        if (value->isNumber()) {
+                            return value->toNumber();
+                        }
+                        break;
+                    case REAL:
+                        if (value->isScalar()) {
+                            return value->toReal();
+                        }
+                        break;
+                    case STRING:
+                        if (value->isString()) {
+                            return value->toString();
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                throw SettingsTypeException(definition.name);
+            }
+
+            std::shared_ptr<ConfigObject> findConfig(const SettingDefinition &definition,
+                    std::shared_ptr<ConfigObject> config) {
+                if (!config.get() || definition.configPath == "") {
+                    return std::shared_ptr<ConfigObject>(nullptr);
+                }
+
+                std::stringstream path(definition.configPath);
+                std::string key;
+                auto current = config;
+                try {
+                    while (std::getline(path, key, '.')) {
+                        if (current->isList()) {
+                            current = current->get(std::stoul(key));
+                        } else {
+                            current = current->get(key);
+                        }
+                    }
+                } catch (ConfigparseCommonException &e) {
+                    return std::shared_ptr<ConfigObject>(nullptr);
+                } catch (std::logic_error &e) {
+                    return std::shared_ptr<ConfigObject>(nullptr);
+                }
+                return current;
+            }
+
+            std::shared_ptr<const SettingsSchema> schema;
+    };
+}
+
+#endif
@@ -1,5 +1,11 @@
 #include "test_argcc.h"
 #include "test_configcc.h"
+#include "test_settingscc.h"
+#include "test_configbind.h"
+#include "test_configwatch.h"
+#include "test_configquery.h"
+#include "test_configparallel.h"
+#include "test_configflat.h"
 
 #include <stdarg.h>
 #include <stddef.h>
@@ -22,13 +28,49 @@ extern "C" {
             // argparse
             cmocka_unit_test(test_argcc),
             cmocka_unit_test(test_argcc_failure),
+            cmocka_unit_test(test_argcc_response_file),
+            cmocka_unit_test(test_argcc_subcommand),
+            cmocka_unit_test(test_argcc_completion),
+            cmocka_unit_test(test_argcc_freeze),
+            cmocka_unit_test(test_argcc_stats),
             // configparse
             cmocka_unit_test(test_object),
             cmocka_unit_test(test_configcc_scanner_isAlphaNumeric),
             cmocka_unit_test(test_configcc_scanner),
             cmocka_unit_test(test_configcc_scanner_failure),
             cmocka_unit_test(test_configcc),
-            cmocka_unit_test(test_configcc_failure)
+            cmocka_unit_test(test_configcc_failure),
+            cmocka_unit_test(test_configcc_events),
+            cmocka_unit_test(test_configcc_schema),
+            cmocka_unit_test(test_configcc_packed),
+            cmocka_unit_test(test_configcc_keys),
+            cmocka_unit_test(test_configcc_snapshot),
+            cmocka_unit_test(test_configcc_include),
+            cmocka_unit_test(test_configcc_merge),
+            cmocka_unit_test(test_configcc_writer),
+            cmocka_unit_test(test_configcc_push),
+            cmocka_unit_test(test_configcc_context),
+            cmocka_unit_test(test_configcc_limits),
+            cmocka_unit_test(test_configcc_memory_resource),
+            cmocka_unit_test(test_configcc_stats),
+            cmocka_unit_test(test_configcc_locations),
+            cmocka_unit_test(test_configcc_index),
+            // configbind
+            cmocka_unit_test(test_configbind),
+            cmocka_unit_test(test_configbind_failure),
+            // configwatch
+            cmocka_unit_test(test_configwatch),
+            // configquery
+            cmocka_unit_test(test_configquery),
+            cmocka_unit_test(test_configquery_errors),
+            // configparallel
+            cmocka_unit_test(test_configparallel),
+            cmocka_unit_test(test_configparallel_failure),
+            // configflat
+            cmocka_unit_test(test_configflat),
+            // settings
+            cmocka_unit_test(test_settingscc),
+            cmocka_unit_test(test_settingscc_failure)
         };
         return cmocka_run_group_tests(tests, NULL, NULL);
     }
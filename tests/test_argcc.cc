@@ -225,3 +225,371 @@ void test_argcc_failure(void **state) {
         });
     }
 }
+
+void test_argcc_response_file(void **state) {
+    char path[] = "/tmp/argcc_response_XXXXXX";
+    int fd = mkstemp(path);
+    assert_true(fd >= 0);
+    std::string content = "string 'Hello World'\n\tfirst second\n \"third value\"  fourth\n";
+    assert_int_equal(write(fd, content.c_str(), content.size()), content.size());
+    close(fd);
+
+    std::string responseArg = std::string("@") + path;
+
+    // stream consumer values to callback
+    {
+        liblc::Argparse parser("Unit test");
+        parser.setResponseFiles(true);
+        parser.addArgument("string", liblc::STRING, 1, "String help", "-s");
+
+        std::vector<std::string> consumed;
+        parser.addConsumer("consumer", "consumer...", [&consumed](std::string_view value) {
+            consumed.push_back(std::string(value));
+        });
+
+        int argc = 4;
+        const char *argv[] = {
+            "test",
+            "-s", "Short",
+            responseArg.c_str()
+        };
+        liblc::Args a = parser.parse(argc, (char**)argv);
+
+        assert_int_equal(a.getSize("string"), 2);
+        assert_cc_string_equal(a.toString("string"), std::string("Short"));
+        assert_cc_string_equal(a.toString("string", 1), std::string("Hello World"));
+        assert_false(a.containsAny("consumer"));
+
+        assert_int_equal(consumed.size(), 4);
+        assert_cc_string_equal(consumed[0], std::string("first"));
+        assert_cc_string_equal(consumed[1], std::string("second"));
+        assert_cc_string_equal(consumed[2], std::string("third value"));
+        assert_cc_string_equal(consumed[3], std::string("fourth"));
+    }
+
+    // lazy range over the file
+    {
+        liblc::ResponseFile file(path);
+        int count = 0;
+        for (auto token : file) {
+            assert_false(token.empty());
+            count++;
+        }
+        assert_int_equal(count, 6);
+    }
+
+    // disabled by default
+    {
+        liblc::Argparse parser("Unit test");
+        parser.addConsumer("consumer", liblc::STRING, "consumer...");
+        int argc = 2;
+        const char *argv[] = {
+            "test",
+            responseArg.c_str()
+        };
+        liblc::Args a = parser.parse(argc, (char**)argv);
+        assert_cc_string_equal(a.toString("consumer"), responseArg);
+    }
+
+    unlink(path);
+
+    {
+        liblc::Argparse parser("Unit test");
+        parser.setResponseFiles(true);
+        int argc = 2;
+        const char *argv[] = {
+            "test",
+            "@/does/not/exist"
+        };
+        assert_throws(liblc::ArgparseResponseFileException, {
+            liblc::Args a = parser.parse(argc, (char**)argv);
+        });
+    }
+
+    // a file that includes itself through another spelling of its path
+    {
+        char self[] = "/tmp/argcc_response_XXXXXX";
+        int fd = mkstemp(self);
+        assert_true(fd >= 0);
+        std::string name = std::string(self).substr(5);
+        std::string content = "first @/tmp/./" + name + "\n";
+        assert_int_equal(write(fd, content.c_str(), content.size()), content.size());
+        close(fd);
+
+        liblc::Argparse parser("Unit test");
+        parser.setResponseFiles(true);
+        parser.addConsumer("consumer", liblc::STRING, "consumer...");
+        std::string selfArg = std::string("@") + self;
+        int argc = 2;
+        const char *argv[] = {
+            "test",
+            selfArg.c_str()
+        };
+        assert_throws(liblc::ArgparseResponseFileCycle, {
+            liblc::Args a = parser.parse(argc, (char**)argv);
+        });
+        unlink(self);
+    }
+
+    // nesting is limited
+    {
+        char paths[3][32] = {"/tmp/argcc_response_XXXXXX", "/tmp/argcc_response_XXXXXX", "/tmp/argcc_response_XXXXXX"};
+        for (auto &path : paths) {
+            close(mkstemp(path));
+        }
+        for (int i = 0; i < 2; i++) {
+            std::string content = std::string("@") + paths[i+1];
+            int fd = open(paths[i], O_WRONLY);
+            assert_int_equal(write(fd, content.c_str(), content.size()), content.size());
+            close(fd);
+        }
+
+        std::string firstArg = std::string("@") + paths[0];
+        int argc = 2;
+        const char *argv[] = {
+            "test",
+            firstArg.c_str()
+        };
+        liblc::Argparse parser("Unit test");
+        parser.setResponseFiles(true, 2);
+        assert_throws(liblc::ArgparseResponseFileDepth, {
+            liblc::Args a = parser.parse(argc, (char**)argv);
+        });
+
+        liblc::Argparse deeper("Unit test");
+        deeper.setResponseFiles(true, 3);
+        liblc::Args a = deeper.parse(argc, (char**)argv);
+        for (auto &path : paths) {
+            unlink(path);
+        }
+    }
+}
+
+void test_argcc_subcommand(void **state) {
+    std::stringstream testOut;
+    liblc::Argparse parser("Unit test", testOut);
+    parser.addArgument("verbose", liblc::BOOLEAN, 0, "verbose", "-v");
+
+    int builtAdd = 0;
+    int builtRemove = 0;
+    parser.addSubcommand("add", "add help", [&builtAdd](liblc::Argparse &sub) {
+        builtAdd++;
+        sub.addArgument("name", liblc::STRING, 1, "name help", "-n");
+        sub.addConsumer("files", liblc::STRING, "files...");
+    });
+    parser.addSubcommand("remove", "remove help", [&builtRemove](liblc::Argparse &sub) {
+        builtRemove++;
+        sub.addArgument("force", liblc::BOOLEAN, 0, "force help", "-f");
+    });
+
+    {
+        int argc = 6;
+        const char *argv[] = {
+            "test",
+            "-v",
+            "add", "-n", "Name", "file"
+        };
+        liblc::Args a = parser.parse(argc, (char**)argv);
+
+        assert_int_equal(builtAdd, 1);
+        assert_int_equal(builtRemove, 0);
+
+        assert_true(a.toBool("verbose"));
+        assert_false(a.containsAny("name"));
+        assert_cc_string_equal(a.getSubcommand(), std::string("add"));
+
+        auto sub = a.getSubcommandArgs();
+        assert_cc_string_equal(sub->toString("name"), std::string("Name"));
+        assert_cc_string_equal(sub->toString("files"), std::string("file"));
+        assert_cc_string_equal(parser.getSubcommandParser()->getProgName(), std::string("add"));
+    }
+
+    {
+        int argc = 1;
+        const char *argv[] = {
+            "test"
+        };
+        liblc::Args a = parser.parse(argc, (char**)argv);
+        assert_cc_string_equal(a.getSubcommand(), std::string(""));
+        assert_null(a.getSubcommandArgs().get());
+        assert_int_equal(builtAdd, 1);
+        assert_int_equal(builtRemove, 0);
+
+        auto help = parser.getHelpText();
+        assert_true(help.find("remove help") != std::string::npos);
+        assert_int_equal(builtRemove, 0);
+    }
+
+    {
+        int argc = 3;
+        const char *argv[] = {
+            "test",
+            "remove", "-n"
+        };
+        assert_throws(liblc::ArgparseInvalidArgument, {
+            liblc::Args a = parser.parse(argc, (char**)argv);
+        });
+        assert_int_equal(builtRemove, 1);
+    }
+}
+
+void test_argcc_completion(void **state) {
+    std::stringstream testOut;
+    liblc::Argparse parser("Unit test", testOut);
+    parser.enableCompletion();
+    parser.addArgument("--string", liblc::STRING, 1, "String help", "-s");
+    parser.addArgument("--strict", liblc::BOOLEAN, 0, "Strict help");
+    parser.addArgument("--number", liblc::NUMBER, 1, "Number help", "-n");
+    parser.addSubcommand("start", "start help", [](liblc::Argparse &sub) {
+        sub.addArgument("--stop-after", liblc::NUMBER, 1, "stop help");
+        sub.addArgument("--delay", liblc::NUMBER, 1, "delay help");
+    });
+
+    {
+        auto candidates = parser.complete(std::vector<std::string> {"--str"});
+        assert_int_equal(candidates.size(), 2);
+        assert_cc_string_equal(candidates[0].first, std::string("--strict"));
+        assert_cc_string_equal(candidates[1].first, std::string("--string"));
+        assert_cc_string_equal(candidates[1].second, std::string("String help"));
+    }
+
+    {
+        auto candidates = parser.complete(std::vector<std::string> {"st"});
+        assert_int_equal(candidates.size(), 1);
+        assert_cc_string_equal(candidates[0].first, std::string("start"));
+    }
+
+    {
+        auto candidates = parser.complete(std::vector<std::string> {"start", "--s"});
+        assert_int_equal(candidates.size(), 1);
+        assert_cc_string_equal(candidates[0].first, std::string("--stop-after"));
+    }
+
+    {
+        int argc = 4;
+        const char *argv[] = {
+            "test",
+            "--complete", "fish", "--n"
+        };
+        liblc::Args a = parser.parse(argc, (char**)argv);
+        assert_true(a.containsAny("--complete"));
+        assert_cc_string_equal(testOut.str(), std::string("--number\tNumber help\n"));
+    }
+
+    assert_cc_string_equal(parser.getCompletionText("bash", std::vector<std::string> {"-"}),
+            std::string("--help\n--number\n--strict\n--string\n-h\n-n\n-s\n"));
+
+    // index is rebuilt after adding arguments
+    parser.addArgument("--numeric", liblc::BOOLEAN, 0, "Numeric help");
+    assert_int_equal(parser.complete(std::vector<std::string> {"--num"}).size(), 2);
+}
+
+void test_argcc_freeze(void **state) {
+    std::stringstream testOut;
+    liblc::Argparse parser("Unit test", testOut);
+    parser.addArgument("string", liblc::STRING, 1, "String help", "-s");
+    parser.addArgument("unique", liblc::STRING, 1, "unique help", "-un", true);
+    parser.addArgument("required", liblc::NUMBER, 1, "required help", "-req", false, true);
+
+    std::string unfrozenHelp = parser.getHelpText();
+    parser.freeze();
+    assert_true(parser.isFrozen());
+    assert_cc_string_equal(parser.getHelpText(), unfrozenHelp);
+    assert_cc_string_equal(parser.getShortName("required"), std::string("-req"));
+    assert_cc_string_equal(parser.getShortName("none"), std::string(""));
+
+    assert_throws(liblc::ArgparseFrozen, {
+        parser.addArgument("late", liblc::STRING, 1, "late help");
+    });
+
+    {
+        int argc = 5;
+        const char *argv[] = {
+            "test",
+            "-s", "Test",
+            "-req", "1"
+        };
+        liblc::Args a = parser.parse(argc, (char**)argv);
+        assert_cc_string_equal(a.toString("string"), std::string("Test"));
+        assert_int_equal(a.toNumber("required"), 1);
+    }
+
+    // seen set is reset between runs
+    {
+        int argc = 3;
+        const char *argv[] = {
+            "test",
+            "-s", "Test"
+        };
+        assert_throws(liblc::ArgparseMissingArgument, {
+            liblc::Args a = parser.parse(argc, (char**)argv);
+        });
+    }
+
+    {
+        int argc = 7;
+        const char *argv[] = {
+            "test",
+            "required", "1",
+            "unique", "a",
+            "-un", "b"
+        };
+        assert_throws(liblc::ArgparseInvalidArgument, {
+            liblc::Args a = parser.parse(argc, (char**)argv);
+        });
+    }
+
+    {
+        int argc = 4;
+        const char *argv[] = {
+            "test",
+            "--help",
+            "required", "1"
+        };
+        liblc::Args a = parser.parse(argc, (char**)argv);
+        assert_cc_string_equal(testOut.str(), parser.getHelpText());
+    }
+}
+
+void test_argcc_stats(void **state) {
+    std::stringstream testOut;
+    liblc::Argparse parser("Unit test", testOut);
+    parser.addArgument("string", liblc::STRING, 1, "String help", "-s");
+    parser.addSubcommand("run", "Run help", [] (liblc::Argparse &sub) {
+        sub.addArgument("--fast", liblc::BOOLEAN, 0, "Fast help");
+    });
+
+    liblc::ArgparseStats stats;
+    int reports = 0;
+    stats.callback = [&reports] (const liblc::ArgparseStats &stats) {
+        reports++;
+    };
+    parser.setStats(&stats);
+
+    int argc = 5;
+    const char *argv[] = {
+        "test",
+        "-s", "Test",
+        "run", "--fast"
+    };
+    liblc::Args a = parser.parse(argc, (char**)argv);
+    assert_true(a.getSubcommandArgs()->toBool("--fast"));
+
+    assert_int_equal(reports, 1);
+    assert_int_equal(stats.tokens, 4);
+    assert_int_equal(stats.bytes, 2 + 4 + 3 + 6);
+    assert_int_equal(stats.arguments, 2);
+    assert_int_equal(stats.subcommands, 1);
+    assert_true(stats.parseTime.count() > 0);
+
+    stats.reset();
+    assert_int_equal(stats.tokens, 0);
+    parser.parse(argc, (char**)argv);
+    assert_int_equal(reports, 2);
+
+    // disabled
+    parser.setStats(nullptr);
+    parser.parse(argc, (char**)argv);
+    assert_int_equal(reports, 2);
+    assert_int_equal(stats.tokens, 4);
+}
@@ -13,4 +13,14 @@ void test_argcc(void **state);
 
 void test_argcc_failure(void **state);
 
+void test_argcc_response_file(void **state);
+
+void test_argcc_subcommand(void **state);
+
+void test_argcc_completion(void **state);
+
+void test_argcc_freeze(void **state);
+
+void test_argcc_stats(void **state);
+
 #endif
@@ -0,0 +1,136 @@
+#include "configbind.h"
+#include "test_configbind.h"
+#include <any>
+
+struct TestEndpoint {
+    std::string host;
+    int port = 0;
+};
+
+struct TestSettings {
+    std::string name;
+    float ratio = 0;
+    bool enabled = false;
+    std::vector<int> weights;
+    std::vector<TestEndpoint> endpoints;
+    std::map<std::string, int> quotas;
+    std::optional<std::string> comment;
+    TestEndpoint primary;
+    int untouched = 42;
+};
+
+CONFIGCC_FIELDS(TestEndpoint,
+        CONFIGCC_FIELD(TestEndpoint, host),
+        CONFIGCC_FIELD(TestEndpoint, port))
+
+CONFIGCC_FIELDS(TestSettings,
+        CONFIGCC_FIELD(TestSettings, name),
+        CONFIGCC_FIELD(TestSettings, ratio),
+        CONFIGCC_FIELD(TestSettings, enabled),
+        CONFIGCC_FIELD(TestSettings, weights),
+        CONFIGCC_FIELD(TestSettings, endpoints),
+        CONFIGCC_FIELD(TestSettings, quotas),
+        CONFIGCC_FIELD(TestSettings, comment),
+        CONFIGCC_FIELD(TestSettings, primary),
+        CONFIGCC_FIELD(TestSettings, untouched))
+
+void test_configbind(void **state) {
+    TestSettings settings;
+    liblc::ConfigDecoder decoder("{\n"
+            "name='test',\n"
+            "ratio=2,\n"
+            "enabled=true,\n"
+            "weights=[1, -2, 3],\n"
+            "endpoints=[{host='a', port=1}, {host='b', port=2, unknown=[1, {x=nil}]}],\n"
+            "quotas={\"a b\"=10, c=-20},\n"
+            "comment=nil,\n"
+            "primary={host='p', port=0x10},\n"
+            "ignored={a=1}\n"
+            "}");
+    decoder.decode(settings);
+
+    assert_cc_string_equal(settings.name, std::string("test"));
+    assert_float_equal(settings.ratio, 2.0, 0.001);
+    assert_true(settings.enabled);
+    assert_int_equal(settings.weights.size(), 3);
+    assert_int_equal(settings.weights[1], -2);
+    assert_int_equal(settings.endpoints.size(), 2);
+    assert_cc_string_equal(settings.endpoints[1].host, std::string("b"));
+    assert_int_equal(settings.endpoints[1].port, 2);
+    assert_int_equal(settings.quotas["a b"], 10);
+    assert_int_equal(settings.quotas["c"], -20);
+    assert_false(settings.comment.has_value());
+    assert_cc_string_equal(settings.primary.host, std::string("p"));
+    assert_int_equal(settings.primary.port, 16);
+    assert_int_equal(settings.untouched, 42);
+
+    std::vector<float> list;
+    liblc::ConfigDecoder listDecoder("[1, 2.5]");
+    listDecoder.decode(list);
+    assert_int_equal(list.size(), 2);
+    assert_float_equal(list[1], 2.5, 0.001);
+}
+
+void test_configbind_failure(void **state) {
+    {
+        TestEndpoint endpoint;
+        liblc::ConfigDecoder decoder("{host='a',\nport='80'}");
+        try {
+            decoder.decode(endpoint);
+            assert_true(false);
+        } catch (liblc::ConfigccDecodeError &e) {
+            assert_int_equal(e.error, liblc::TYPE_ERROR);
+            assert_int_equal(e.token->getLine(), 2);
+            assert_int_equal(e.token->getTokenStart(), 16);
+        }
+    }
+
+    {
+        TestEndpoint endpoint;
+        liblc::ConfigDecoder decoder("[1]");
+        assert_throws(liblc::ConfigccDecodeError, {decoder.decode(endpoint);});
+    }
+
+    {
+        TestEndpoint endpoint;
+        liblc::ConfigDecoder decoder("{host='a' port=1}");
+        assert_throws(liblc::ConfigccParserError, {decoder.decode(endpoint);});
+    }
+
+    {
+        TestEndpoint endpoint;
+        liblc::ConfigDecoder decoder("{host='a'} 1");
+        assert_throws(liblc::ConfigccParserError, {decoder.decode(endpoint);});
+    }
+
+    {
+        TestEndpoint endpoint;
+        liblc::ConfigDecoder decoder("{x=[[1], {a=[2,]}, [{}]], host='a'");
+        assert_throws(liblc::ConfigccParserError, {decoder.decode(endpoint);});
+        liblc::ConfigDecoder unclosed("{x=[[1], {a=2}, host='a'}");
+        assert_throws(liblc::ConfigccParserError, {unclosed.decode(endpoint);});
+    }
+
+    {
+        // unknown keys are skipped without recursion
+        std::string nested(200000, '[');
+        nested += std::string(200000, ']');
+        TestEndpoint endpoint;
+        liblc::ConfigDecoder decoder("{x=" + nested + ", port=1}");
+        decoder.decode(endpoint);
+        assert_int_equal(endpoint.port, 1);
+
+        liblc::ConfigLimits limits;
+        limits.maxDepth = 3;
+        liblc::ConfigDecoder limited("{x=[[[1]]], port=1}", "", limits);
+        try {
+            limited.decode(endpoint);
+            assert_true(false);
+        } catch (liblc::ConfigccLimitError &e) {
+            assert_int_equal(e.error, liblc::DEPTH_LIMIT_EXCEEDED);
+        }
+        liblc::ConfigDecoder allowed("{x=[[1]], port=2}", "", limits);
+        allowed.decode(endpoint);
+        assert_int_equal(endpoint.port, 2);
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef __TEST_CC_CONFIGBIND_H__
+#define __TEST_CC_CONFIGBIND_H__
+
+#include "macros.h"
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+void test_configbind(void **state);
+
+void test_configbind_failure(void **state);
+
+#endif
@@ -1,6 +1,11 @@
 #include "configcc.h"
 #include "test_configcc.h"
 #include <any>
+#include <thread>
+#include <fstream>
+#include <unistd.h>
+#include <pthread.h>
+#include <utility>
 
 void test_unescape(void **state) {
     std::string unescaped = liblc::unescape("Hello \\\"World\\\"\\nTHis.\\tIs\\nAn\\vEscaped\\rString!\\\\");
@@ -333,3 +338,1283 @@ void test_configcc_failure(void **state) {
     test_parser_error("{a=1 b=2}");
     test_parser_error("[1 2]");
 }
+
+class TestEventHandler: public liblc::ConfigEventHandler {
+    public:
+        virtual bool onSectionStart() {
+            events << "{";
+            return lastKey != "skip";
+        }
+
+        virtual void onSectionEnd() {
+            events << "}";
+        }
+
+        virtual void onKey(const std::string &key) {
+            lastKey = key;
+            events << key << "=";
+        }
+
+        virtual bool onListStart() {
+            events << "[";
+            return true;
+        }
+
+        virtual void onListEnd() {
+            events << "]";
+        }
+
+        virtual void onNumber(liblc::ConfigNumber value) {
+            sum += value;
+            events << value << ",";
+        }
+
+        virtual void onReal(liblc::ConfigReal value) {
+            events << value << ",";
+        }
+
+        virtual void onString(const std::string &value) {
+            if (lastKey == "endpoint") {
+                endpoints.push_back(value);
+            }
+            events << value << ",";
+        }
+
+        virtual void onBool(liblc::ConfigBool value) {
+            events << (value ? "true" : "false") << ",";
+        }
+
+        virtual void onNil() {
+            events << "nil,";
+        }
+
+        std::stringstream events;
+        std::string lastKey;
+        std::vector<std::string> endpoints;
+        int sum = 0;
+};
+
+void test_configcc_events(void **state) {
+    {
+        TestEventHandler handler;
+        liblc::ConfigEventParser parser("{a=1, list=[2, -3, 1.5], b={endpoint='x', c=true},"
+                "skip={endpoint='hidden', n=100}, endpoint=\"y\", d=nil}");
+        parser.parse(&handler);
+
+        assert_int_equal(handler.sum, 0);
+        assert_int_equal(handler.endpoints.size(), 2);
+        assert_cc_string_equal(handler.endpoints[0], std::string("x"));
+        assert_cc_string_equal(handler.endpoints[1], std::string("y"));
+        assert_cc_string_equal(handler.events.str(),
+                std::string("{a=1,list=[2,-3,1.5,]b={endpoint=x,c=true,}skip={endpoint=y,d=nil,}"));
+    }
+
+    {
+        TestEventHandler handler;
+        liblc::ConfigEventParser parser("");
+        parser.parse(&handler);
+        assert_cc_string_equal(handler.events.str(), std::string("{}"));
+    }
+
+    {
+        TestEventHandler handler;
+        liblc::ConfigEventParser parser("{a=1 b=2}");
+        assert_throws(liblc::ConfigccParserError, {parser.parse(&handler);});
+    }
+
+    {
+        TestEventHandler handler;
+        liblc::ConfigEventParser parser("[1, 2] 3");
+        assert_throws(liblc::ConfigccParserError, {parser.parse(&handler);});
+    }
+}
+
+#define test_schema_error(input, schema, expectedError, expectedLine) {\
+    liblc::ConfigParser parser(input);\
+    parser.setSchema(schema);\
+    try {\
+        parser.parse();\
+        assert_true(false);\
+    } catch (liblc::ConfigccSchemaError &e) {\
+        assert_int_equal(e.error, expectedError);\
+        assert_int_equal(e.token->getLine(), expectedLine);\
+    }\
+}
+
+void test_configcc_schema(void **state) {
+    auto schema = std::make_shared<liblc::ConfigSchema>(liblc::SECTION);
+    auto server = schema->addKey("server", liblc::SECTION, true);
+    server->addKey("host", liblc::STRING, true);
+    server->addKey("port", liblc::NUMBER)->setRange(1, 65535);
+    server->addKey("mode", liblc::STRING)->setAllowed(std::vector<std::string> {"fast", "safe"});
+    auto weights = schema->addKey("weights", liblc::LIST);
+    weights->setElements(liblc::REAL);
+    weights->setRange(0, 3);
+    schema->addKey("comment", liblc::STRING)->setNullable(true);
+
+    {
+        liblc::ConfigParser parser("{server={host='a', port=80, mode='safe', extra=1}, weights=[1, 2.5], comment=nil}");
+        parser.setSchema(schema);
+        auto root = parser.parse();
+        assert_int_equal(root->get("server")->get("port")->toNumber(), 80);
+    }
+
+    test_schema_error("{server={host='a',\nport=0}}", schema, liblc::SCHEMA_OUT_OF_RANGE, 2);
+    test_schema_error("{server={host='a', port=1.5}}", schema, liblc::SCHEMA_TYPE_ERROR, 1);
+    test_schema_error("{server={host='a', mode='slow'}}", schema, liblc::SCHEMA_INVALID_VALUE, 1);
+    test_schema_error("{server={port=1\n}}", schema, liblc::SCHEMA_MISSING_KEY, 2);
+    test_schema_error("{server={host='a'}, weights=['a']}", schema, liblc::SCHEMA_TYPE_ERROR, 1);
+    test_schema_error("{server={host='a'}, weights=[1, 2, 3, 4]}", schema, liblc::SCHEMA_OUT_OF_RANGE, 1);
+    test_schema_error("{server={host=nil}}", schema, liblc::SCHEMA_TYPE_ERROR, 1);
+    test_schema_error("", schema, liblc::SCHEMA_MISSING_KEY, 1);
+    test_schema_error("[]", schema, liblc::SCHEMA_TYPE_ERROR, 1);
+
+    schema->setStrict(true);
+    test_schema_error("{server={host='a'},\nunknown=1}", schema, liblc::SCHEMA_UNKNOWN_KEY, 2);
+
+    // children changed after the first compile are used by the next parse
+    server->addKey("user", liblc::STRING, true);
+    test_schema_error("{server={host='a'}}", schema, liblc::SCHEMA_MISSING_KEY, 1);
+
+    // a schema may refer to itself
+    auto tree = std::make_shared<liblc::ConfigSchema>(liblc::SECTION);
+    tree->addKey("name", liblc::STRING, true);
+    tree->addKey("children", liblc::LIST)->setElements(tree);
+    {
+        liblc::ConfigParser parser("{name='a', children=[{name='b', children=[]}]}");
+        parser.setSchema(tree);
+        parser.parse();
+    }
+    test_schema_error("{name='a', children=[{children=[]}]}", tree, liblc::SCHEMA_MISSING_KEY, 1);
+    unsigned long treeVersion = tree->getVersion();
+    tree->addKey("children", liblc::LIST);
+    assert_true(tree->getVersion() != treeVersion);
+
+    // versions only change with the schema or its children
+    unsigned long version = schema->getVersion();
+    auto unrelated = std::make_shared<liblc::ConfigSchema>(liblc::SECTION);
+    unrelated->addKey("other", liblc::NUMBER);
+    assert_int_equal(schema->getVersion(), version);
+    server->addKey("timeout", liblc::NUMBER);
+    assert_true(schema->getVersion() != version);
+
+    // parsers may share a schema across threads
+    std::vector<std::thread> threads;
+    std::atomic<int> failures { 0 };
+    for (int i = 0; i < 4; i++) {
+        threads.push_back(std::thread([&schema, &failures]() {
+            for (int j = 0; j < 50; j++) {
+                liblc::ConfigParser parser("{server={host='a', user='b'}}");
+                parser.setSchema(schema);
+                if (parser.parse()->get("server")->getSize() != 2) {
+                    failures++;
+                }
+            }
+        }));
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    assert_int_equal(failures.load(), 0);
+}
+
+void test_configcc_packed(void **state) {
+    {
+        liblc::ConfigParser parser("{n=[1, -2, +3], r=[1.5, -2.5], mixed=[1, 2.5, 'a'], empty=[]}");
+        auto root = parser.parse();
+
+        auto n = root->get("n");
+        assert_true(n->isList());
+        assert_true(n->isPacked());
+        assert_int_equal(n->getPackedType(), liblc::NUMBER);
+        assert_int_equal(n->getSize(), 3);
+        int sum = 0;
+        for (auto value : n->toNumberSpan()) {
+            sum += value;
+        }
+        assert_int_equal(sum, 2);
+        assert_int_equal(n->get(1)->toNumber(), -2);
+        assert_throws(liblc::ConfigccOutOfBounds, {n->get(3);});
+        assert_throws(liblc::ConfigccTypeError, {n->toRealSpan();});
+
+        auto r = root->get("r");
+        assert_true(r->isPacked());
+        assert_float_equal(r->toRealSpan()[1], -2.5, 0.001);
+        assert_float_equal(r->get(0)->toReal(), 1.5, 0.001);
+
+        auto mixed = root->get("mixed");
+        assert_false(mixed->isPacked());
+        assert_int_equal(mixed->getSize(), 3);
+        assert_int_equal(mixed->get(0)->toNumber(), 1);
+        assert_float_equal(mixed->get(1)->toReal(), 2.5, 0.001);
+
+        assert_false(root->get("empty")->isPacked());
+
+        // reads do not unpack and reuse the same element objects
+        auto list = std::as_const(*n).toList();
+        assert_true(n->isPacked());
+        assert_int_equal(list->size(), 3);
+        assert_int_equal(list->at(2)->toNumber(), 3);
+        assert_true(n->get(2) == list->at(2));
+        assert_true(n->get(0) == n->get(0));
+
+        // unpacked on explicit request
+        n->unpack();
+        assert_false(n->isPacked());
+        n->toList()->push_back(n->get(0));
+        assert_int_equal(n->getSize(), 4);
+        assert_int_equal(list->size(), 3);
+
+        // and before the list can be modified
+        liblc::ConfigStringify stringify;
+        auto appended = liblc::ConfigParser("{l=[1, 2]}").parse();
+        appended->get("l")->toList()->push_back(std::make_shared<liblc::ConfigObject>(liblc::NUMBER, 3));
+        assert_false(appended->get("l")->isPacked());
+        assert_int_equal(appended->get("l")->getSize(), 3);
+        assert_cc_string_equal(stringify.stringify(appended->get("l")), std::string("[1, 2, 3]"));
+    }
+
+    test_parser_full("[1.5, -2.5, 3.25]", "[1.5, -2.5, 3.25]");
+    test_parser_full("[1, 2, 3.5, 4]", "[1, 2, 3.5, 4]");
+}
+
+void test_configcc_keys(void **state) {
+    auto table = std::make_shared<liblc::ConfigKeyTable>();
+    auto host = table->intern("host");
+    assert_true(host.isSame(table->intern("host")));
+    assert_false(host.isSame(liblc::ConfigKey("host")));
+    assert_true(host == liblc::ConfigKey("host"));
+
+    liblc::ConfigParser first("[{host='a', port=1}, {host='b', port=2}]");
+    liblc::ConfigParser second("{host='c', timeout=3}");
+    first.setKeyTable(table);
+    second.setKeyTable(table);
+    auto firstRoot = first.parse();
+    auto secondRoot = second.parse();
+
+    // host, port and timeout
+    assert_int_equal(table->getSize(), 3);
+
+    auto a = firstRoot->get(0)->toSection()->begin()->first;
+    auto b = firstRoot->get(1)->toSection()->begin()->first;
+    auto c = secondRoot->toSection()->begin()->first;
+    assert_true(a.isSame(b));
+    assert_true(a.isSame(c));
+    assert_true(a.isSame(host));
+
+    // interned and string lookups
+    assert_cc_string_equal(secondRoot->get(host)->toString(), std::string("c"));
+    assert_int_equal(secondRoot->get("timeout")->toNumber(), 3);
+    assert_int_equal(secondRoot->get(liblc::ConfigKey("timeout"))->toNumber(), 3);
+    assert_throws(liblc::ConfigccKeyNotFound, {secondRoot->get(table->intern("port"));});
+
+    // keys only stay in the table while documents use them
+    assert_int_equal(table->purge(), 0);
+    firstRoot.reset();
+    host = liblc::ConfigKey("host");
+    assert_int_equal(table->purge(), 1);
+    assert_int_equal(table->getSize(), 2);
+    secondRoot.reset();
+    a = b = c = host;
+    assert_int_equal(table->purge(), 2);
+    assert_int_equal(table->getSize(), 0);
+
+    // parsers use their own table that does not lock
+    liblc::ConfigParser third("{a=1}");
+    assert_false(third.getKeyTable()->isConcurrent());
+    assert_true(table->isConcurrent());
+}
+
+void test_configcc_snapshot(void **state) {
+    liblc::ConfigPublisher publisher;
+    liblc::ConfigReader reader(publisher);
+    assert_int_equal(reader.get().getVersion(), 0);
+    assert_int_equal(reader.getRoot()->getSize(), 0);
+
+    {
+        liblc::ConfigParser parser("{a=1, list=[1, 2], s={b='x'}}");
+        assert_int_equal(publisher.publish(parser.parse()), 1);
+    }
+
+    std::shared_ptr<const liblc::ConfigObject> root = reader.getRoot();
+    assert_int_equal(reader.get().getVersion(), 1);
+    assert_int_equal(root->get("a")->toNumber(), 1);
+    assert_int_equal(root->get("list")->get(1)->toNumber(), 2);
+    assert_int_equal(root->get("list")->toList()->size(), 2);
+    assert_cc_string_equal(root->get("s")->get("b")->toString(), std::string("x"));
+
+    // children of a snapshot are const all the way down
+    auto list = root->get("list")->toList();
+    static_assert(std::is_same<decltype(list.at(0)), std::shared_ptr<const liblc::ConfigObject>>::value);
+    static_assert(std::is_same<decltype(*list.begin()), std::shared_ptr<const liblc::ConfigObject>>::value);
+    auto section = root->toSection();
+    static_assert(std::is_same<decltype(section->find("a")->second), std::shared_ptr<const liblc::ConfigObject>>::value);
+    int sum = 0;
+    for (auto element : list) {
+        sum += element->toNumber();
+    }
+    assert_int_equal(sum, 3);
+    std::string keys;
+    for (auto entry : section) {
+        keys += entry.first.str();
+    }
+    assert_cc_string_equal(keys, std::string("alists"));
+    assert_int_equal(section->find("s")->second->getSize(), 1);
+    assert_true(section->find("missing") == section->end());
+
+    // old snapshot stays valid while readers hold it
+    auto old = publisher.load();
+    {
+        liblc::ConfigParser parser("{a=2}");
+        publisher.publish(parser.parse());
+    }
+    assert_int_equal(old->getRoot()->get("a")->toNumber(), 1);
+    assert_int_equal(reader.getRoot()->get("a")->toNumber(), 2);
+
+    std::vector<std::thread> threads;
+    std::atomic<int> failures(0);
+    for (int i = 0; i < 4; i++) {
+        threads.push_back(std::thread([&publisher, &failures]() {
+            liblc::ConfigReader threadReader(publisher);
+            for (int j = 0; j < 1000; j++) {
+                auto value = threadReader.getRoot()->get("a")->toNumber();
+                if (value < 2) {
+                    failures++;
+                }
+            }
+        }));
+    }
+    for (int i = 0; i < 100; i++) {
+        liblc::ConfigParser parser("{a=" + std::to_string(i + 3) + "}");
+        publisher.publish(parser.parse());
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    assert_int_equal(failures.load(), 0);
+    assert_int_equal(reader.getRoot()->get("a")->toNumber(), 102);
+}
+
+static void writeTestFile(std::string path, std::string content) {
+    std::ofstream file(path);
+    file << content;
+}
+
+#define test_limit_error_in(path, input, limits, cache, expectedError) {\
+    try {\
+        liblc::ConfigParser parser(input, path, limits);\
+        parser.setIncludeCache(cache);\
+        parser.parse();\
+        assert_true(false);\
+    } catch (liblc::ConfigccLimitError &e) {\
+        assert_int_equal(e.error, expectedError);\
+    }\
+}
+
+void test_configcc_include(void **state) {
+    char dir[] = "/tmp/configcc_include_XXXXXX";
+    assert_non_null(mkdtemp(dir));
+    std::string base = std::string(dir) + "/";
+    writeTestFile(base + "tls.cfg", "{cert='a.pem', key='a.key'}");
+    writeTestFile(base + "broken.cfg", "{a=1,\nb=}");
+    writeTestFile(base + "loop.cfg", "{self=include 'loop2.cfg'}");
+    writeTestFile(base + "loop2.cfg", "[include 'loop.cfg']");
+    writeTestFile(base + "dotloop.cfg", "{self=include './dotloop.cfg'}");
+    writeTestFile(base + "deep.cfg", "[[[1, 2]]]");
+
+    auto cache = std::make_shared<liblc::ConfigIncludeCache>();
+    {
+        liblc::ConfigParser parser("{a={tls=include 'tls.cfg'}, b=[include \"tls.cfg\"], include=1}", base + "main.cfg");
+        parser.setIncludeCache(cache);
+        auto root = parser.parse();
+
+        auto a = root->get("a")->get("tls");
+        auto b = root->get("b")->get(0);
+        assert_cc_string_equal(a->get("cert")->toString(), std::string("a.pem"));
+        // parsed once and copied into every include
+        assert_true(a.get() != b.get());
+        assert_int_equal(cache->getSize(), 1);
+        assert_int_equal(root->get("include")->toNumber(), 1);
+
+        // changes stay in the document that made them
+        a->toSection()->erase(liblc::ConfigKey("cert"));
+        assert_cc_string_equal(b->get("cert")->toString(), std::string("a.pem"));
+        liblc::ConfigParser again("{tls=include 'tls.cfg'}", base + "main.cfg");
+        again.setIncludeCache(cache);
+        assert_cc_string_equal(again.parse()->get("tls")->get("cert")->toString(), std::string("a.pem"));
+    }
+
+    {
+        liblc::ConfigParser parser("{tls=include '" + base + "tls.cfg'}");
+        parser.setIncludeCache(cache);
+        auto first = cache->getSize();
+        parser.parse();
+        assert_int_equal(cache->getSize(), first);
+    }
+
+    {
+        liblc::ConfigParser parser("{a=include 'broken.cfg'}", base + "main.cfg");
+        try {
+            parser.parse();
+            assert_true(false);
+        } catch (liblc::ConfigccParserError &e) {
+            assert_cc_string_equal(e.token->getPath(), (base + "broken.cfg"));
+            assert_int_equal(e.token->getLine(), 2);
+        }
+    }
+
+    {
+        liblc::ConfigParser parser("{a=include 'missing.cfg'}", base + "main.cfg");
+        try {
+            parser.parse();
+            assert_true(false);
+        } catch (liblc::ConfigccParserError &e) {
+            assert_int_equal(e.error, liblc::INCLUDE_NOT_FOUND);
+            assert_cc_string_equal(e.token->getPath(), (base + "main.cfg"));
+        }
+    }
+
+    {
+        liblc::ConfigParser parser("{a=include 'loop.cfg'}", base + "main.cfg");
+        try {
+            parser.parse();
+            assert_true(false);
+        } catch (liblc::ConfigccParserError &e) {
+            assert_int_equal(e.error, liblc::INCLUDE_CYCLE);
+        }
+    }
+
+    {
+        // the same file through a different path
+        liblc::ConfigParser parser("{a=include 'dotloop.cfg'}", base + "main.cfg");
+        try {
+            parser.parse();
+            assert_true(false);
+        } catch (liblc::ConfigccParserError &e) {
+            assert_int_equal(e.error, liblc::INCLUDE_CYCLE);
+        }
+
+        auto sharedCache = std::make_shared<liblc::ConfigIncludeCache>();
+        liblc::ConfigParser shared("{a=include 'tls.cfg', b=include './tls.cfg'}", base + "main.cfg");
+        shared.setIncludeCache(sharedCache);
+        auto root = shared.parse();
+        assert_cc_string_equal(root->get("b")->get("key")->toString(), std::string("a.key"));
+        assert_int_equal(sharedCache->getSize(), 1);
+    }
+
+    {
+        // entries are parsed again when a file they include changed
+        writeTestFile(base + "top.cfg", "{a=include 'a.cfg'}");
+        writeTestFile(base + "a.cfg", "{b=include 'b.cfg'}");
+        writeTestFile(base + "b.cfg", "{v=1}");
+        auto nestedCache = std::make_shared<liblc::ConfigIncludeCache>();
+        liblc::ConfigParser first("{top=include 'top.cfg'}", base + "main.cfg");
+        first.setIncludeCache(nestedCache);
+        assert_int_equal(first.parse()->get("top")->get("a")->get("b")->get("v")->toNumber(), 1);
+
+        writeTestFile(base + "b.cfg", "{v=2, w=3}");
+        liblc::ConfigParser second("{top=include 'top.cfg'}", base + "main.cfg");
+        second.setIncludeCache(nestedCache);
+        assert_int_equal(second.parse()->get("top")->get("a")->get("b")->get("v")->toNumber(), 2);
+
+        unlink((base + "b.cfg").c_str());
+        liblc::ConfigParser removed("{top=include 'top.cfg'}", base + "main.cfg");
+        removed.setIncludeCache(nestedCache);
+        assert_throws(liblc::ConfigccParserError, {removed.parse();});
+    }
+
+    {
+        // included documents are validated completely
+        auto schema = std::make_shared<liblc::ConfigSchema>(liblc::SECTION);
+        auto tls = schema->addKey("tls", liblc::SECTION);
+        tls->addKey("cert", liblc::STRING, true);
+        tls->addKey("ca", liblc::STRING, true);
+
+        liblc::ConfigParser parser("{tls=include 'tls.cfg'}", base + "main.cfg");
+        parser.setIncludeCache(cache);
+        parser.setSchema(schema);
+        try {
+            parser.parse();
+            assert_true(false);
+        } catch (liblc::ConfigccSchemaError &e) {
+            assert_int_equal(e.error, liblc::SCHEMA_MISSING_KEY);
+            assert_cc_string_equal(e.token->getPath(), (base + "tls.cfg"));
+        }
+
+        // validated documents are cached separately
+        tls->addKey("ca", liblc::STRING);
+        liblc::ConfigParser valid("{tls=include 'tls.cfg'}", base + "main.cfg");
+        valid.setIncludeCache(cache);
+        valid.setSchema(schema);
+        assert_cc_string_equal(valid.parse()->get("tls")->get("key")->toString(), std::string("a.key"));
+
+        // and validated again after the schema changed
+        tls->addKey("key", liblc::NUMBER);
+        liblc::ConfigParser changed("{tls=include 'tls.cfg'}", base + "main.cfg");
+        changed.setIncludeCache(cache);
+        changed.setSchema(schema);
+        assert_throws(liblc::ConfigccSchemaError, {changed.parse();});
+    }
+
+    {
+        // limits count included documents, parsed or cached
+        auto limitCache = std::make_shared<liblc::ConfigIncludeCache>();
+        for (int i = 0; i < 2; i++) {
+            liblc::ConfigLimits limits;
+            limits.maxDepth = 4;
+            test_limit_error_in(base + "main.cfg", "{a=[include 'deep.cfg']}", limits, limitCache,
+                    liblc::DEPTH_LIMIT_EXCEEDED);
+            limits.maxDepth = 5;
+            liblc::ConfigParser parser("{a=[include 'deep.cfg']}", base + "main.cfg", limits);
+            parser.setIncludeCache(limitCache);
+            assert_int_equal(parser.parse()->get("a")->get(0)->get(0)->get(0)->getSize(), 2);
+
+            limits = liblc::ConfigLimits();
+            limits.maxNodes = 7;
+            test_limit_error_in(base + "main.cfg", "{a=include 'deep.cfg', b=1}", limits, limitCache,
+                    liblc::NODE_LIMIT_EXCEEDED);
+            limits.maxNodes = 8;
+            liblc::ConfigParser nodeParser("{a=include 'deep.cfg', b=1}", base + "main.cfg", limits);
+            nodeParser.setIncludeCache(limitCache);
+            assert_int_equal(nodeParser.parse()->get("b")->toNumber(), 1);
+        }
+        assert_int_equal(limitCache->getSize(), 1);
+    }
+
+    {
+        // cached includes do not use memory of a released resource
+        auto sharedCache = std::make_shared<liblc::ConfigIncludeCache>();
+        {
+            std::pmr::monotonic_buffer_resource resource;
+            liblc::ConfigParser parser("{tls=include 'tls.cfg'}", base + "main.cfg");
+            parser.setIncludeCache(sharedCache);
+            parser.setMemoryResource(&resource);
+            auto root = parser.parse();
+            assert_true(root->toSection()->get_allocator().resource() == &resource);
+            // the document holds a copy, the cached root stays outside of resource
+            assert_true(root->get("tls")->toSection()->get_allocator().resource() == &resource);
+        }
+        liblc::ConfigParser parser("{tls=include 'tls.cfg'}", base + "main.cfg");
+        parser.setIncludeCache(sharedCache);
+        assert_cc_string_equal(parser.parse()->get("tls")->get("cert")->toString(), std::string("a.pem"));
+    }
+
+    test_parser_error("{a=include 1}");
+
+    for (auto name : std::vector<std::string> {"tls.cfg", "broken.cfg", "loop.cfg", "loop2.cfg", "dotloop.cfg",
+            "deep.cfg", "top.cfg", "a.cfg"}) {
+        unlink((base + name).c_str());
+    }
+    rmdir(dir);
+}
+
+void test_configcc_merge(void **state) {
+    liblc::ConfigParser baseParser("{server={host='base', port=80, tls={cert='a'}}, list=[1, 2], names=['a'], keep={x=1}}");
+    liblc::ConfigParser regionParser("{server={port=8080}, list=[3], names=['b'], region='eu'}");
+    liblc::ConfigParser hostParser("{server={host='host'}}");
+    auto base = baseParser.parse();
+    auto region = regionParser.parse();
+    auto host = hostParser.parse();
+
+    {
+        liblc::ConfigMerger merger;
+        auto merged = merger.merge(std::vector<std::shared_ptr<liblc::ConfigObject>> {base, region, host});
+
+        assert_cc_string_equal(merged->get("server")->get("host")->toString(), std::string("host"));
+        assert_int_equal(merged->get("server")->get("port")->toNumber(), 8080);
+        assert_cc_string_equal(merged->get("region")->toString(), std::string("eu"));
+        assert_int_equal(merged->get("list")->getSize(), 1);
+
+        // untouched subtrees are shared
+        assert_true(merged->get("keep").get() == base->get("keep").get());
+        assert_true(merged->get("server")->get("tls").get() == base->get("server")->get("tls").get());
+
+        // inputs are unchanged
+        assert_int_equal(base->get("server")->get("port")->toNumber(), 80);
+        assert_cc_string_equal(base->get("server")->get("host")->toString(), std::string("base"));
+    }
+
+    {
+        liblc::ConfigMerger merger(liblc::MERGE_DEEP, liblc::MERGE_APPEND);
+        auto merged = merger.merge(base, region);
+        auto list = merged->get("list");
+        assert_true(list->isPacked());
+        assert_int_equal(list->getSize(), 3);
+        assert_int_equal(list->get(2)->toNumber(), 3);
+        assert_int_equal(merged->get("names")->getSize(), 2);
+        assert_cc_string_equal(merged->get("names")->get(1)->toString(), std::string("b"));
+        assert_true(base->get("names")->getSize() == 1);
+    }
+
+    {
+        liblc::ConfigMerger merger(liblc::MERGE_REPLACE);
+        auto merged = merger.merge(base, region);
+        assert_true(merged.get() == region.get());
+    }
+
+    // layers merged at once behave like merging them one by one
+    {
+        liblc::ConfigParser first("{s={a=1, deep={x=1}}, r={a=1}, l=[1], keep=1}");
+        liblc::ConfigParser second("{s={b=2, deep={y=2}}, r=1, l=[2]}");
+        liblc::ConfigParser third("{s={c=3, deep={x=3}}, r={b=2}, l=[3, 4]}");
+        std::vector<std::shared_ptr<liblc::ConfigObject>> layers {first.parse(), second.parse(), third.parse()};
+
+        liblc::ConfigMerger merger(liblc::MERGE_DEEP, liblc::MERGE_APPEND);
+        liblc::ConfigStringify stringify;
+        auto merged = merger.merge(layers);
+        auto stepwise = merger.merge(merger.merge(layers[0], layers[1]), layers[2]);
+        assert_cc_string_equal(stringify.stringify(merged), stringify.stringify(stepwise));
+        assert_int_equal(merged->get("s")->getSize(), 4);
+        assert_int_equal(merged->get("s")->get("deep")->get("x")->toNumber(), 3);
+        assert_int_equal(merged->get("r")->getSize(), 1);
+        assert_int_equal(merged->get("l")->getSize(), 4);
+        assert_true(merged->get("s")->get("a").get() == layers[0]->get("s")->get("a").get());
+    }
+
+    // duplicate keys, last one wins
+    {
+        liblc::ConfigParser parser("{a=1, a=2}");
+        assert_int_equal(parser.parse()->get("a")->toNumber(), 2);
+    }
+}
+
+void test_configcc_writer(void **state) {
+    {
+        std::stringstream out;
+        {
+            liblc::ConfigWriter writer(out, 8);
+            writer.beginSection();
+            writer.key("a");
+            writer.value(1);
+            writer.key("list");
+            writer.beginList();
+            writer.value(-2);
+            writer.value(1.5f);
+            writer.value("quote \" and\nnewline");
+            writer.value(true);
+            writer.value(nullptr);
+            writer.beginSection();
+            writer.endSection();
+            writer.endList();
+            writer.key("key with space");
+            writer.value(std::string("x"));
+            writer.endSection();
+            assert_true(writer.isComplete());
+        }
+        assert_cc_string_equal(out.str(), std::string("{\"a\"=1, \"list\"=[-2, 1.5, \"quote \\\" and\\nnewline\", true, nil, {}], \"key with space\"=\"x\"}"));
+
+        // round trip
+        liblc::ConfigParser parser(out.str());
+        auto root = parser.parse();
+        assert_cc_string_equal(root->get("list")->get(2)->toString(), std::string("quote \" and\nnewline"));
+    }
+
+    {
+        std::stringstream out;
+        liblc::ConfigWriter writer(out);
+        assert_throws(liblc::ConfigWriterError, {writer.key("a");});
+        writer.beginSection();
+        assert_throws(liblc::ConfigWriterError, {writer.value(1);});
+        assert_throws(liblc::ConfigWriterError, {writer.endList();});
+        writer.key("a");
+        assert_throws(liblc::ConfigWriterError, {writer.endSection();});
+        writer.value(1);
+        writer.endSection();
+        assert_throws(liblc::ConfigWriterError, {writer.value(2);});
+    }
+
+    // reals keep their value and type
+    {
+        std::vector<liblc::ConfigReal> reals {2.0f, 0.1f, -0.5f, 1e10f, 123456.789f, 3.4028235e38f,
+            1.17549435e-38f, 1.4e-45f, 0.3f, -7.0f};
+        std::stringstream out;
+        {
+            liblc::ConfigWriter writer(out);
+            writer.beginList();
+            for (auto real : reals) {
+                writer.value(real);
+            }
+            writer.endList();
+        }
+        assert_int_equal(out.str().find('e'), std::string::npos);
+        assert_true(out.str().find("[2.0, 0.1, -0.5, 10000000000.0,") == 0);
+
+        liblc::ConfigParser parser(out.str());
+        auto root = parser.parse();
+        assert_int_equal(root->getSize(), reals.size());
+        for (size_t i = 0; i < reals.size(); i++) {
+            assert_true(root->get(i)->isReal());
+            assert_true(root->get(i)->toReal() == reals[i]);
+        }
+    }
+
+    {
+        std::stringstream out;
+        liblc::ConfigWriter writer(out);
+        writer.beginList();
+        assert_throws(liblc::ConfigWriterError, {writer.value(std::numeric_limits<liblc::ConfigReal>::quiet_NaN());});
+        assert_throws(liblc::ConfigWriterError, {writer.value(std::numeric_limits<liblc::ConfigReal>::infinity());});
+        writer.value(1.5f);
+        writer.endList();
+        writer.flush();
+        assert_cc_string_equal(out.str(), std::string("[1.5]"));
+    }
+}
+
+void test_configcc_push(void **state) {
+    const std::string doc = "{a = 0x1f, 'b\\'c' = [-1.5, \"x\\\"y\", nil], // comment\n d = { e = true }}";
+
+    // every split point of a single document
+    for (size_t split = 0; split <= doc.size(); split++) {
+        std::vector<std::shared_ptr<liblc::ConfigObject>> docs;
+        liblc::ConfigPushParser parser([&docs] (std::shared_ptr<liblc::ConfigObject> root) {
+            docs.push_back(root);
+        });
+        parser.feed(doc.c_str(), split);
+        parser.feed(doc.c_str()+split, doc.size()-split);
+        parser.finish();
+
+        assert_int_equal(docs.size(), 1);
+        assert_int_equal(docs[0]->get("a")->toNumber(), 31);
+        assert_float_equal(docs[0]->get("b'c")->get(0)->toReal(), -1.5, 0.001);
+        assert_cc_string_equal(docs[0]->get("b'c")->get(1)->toString(), std::string("x\"y"));
+        assert_true(docs[0]->get("b'c")->get(2)->isNil());
+        assert_true(docs[0]->get("d")->get("e")->toBool());
+    }
+
+    {
+        // byte by byte, back to back documents
+        const std::string stream = "{a=1}[1, 2]\n'str' {} 12";
+        std::vector<std::shared_ptr<liblc::ConfigObject>> docs;
+        liblc::ConfigPushParser parser([&docs] (std::shared_ptr<liblc::ConfigObject> root) {
+            docs.push_back(root);
+        });
+        for (char c : stream) {
+            parser.feed(&c, 1);
+        }
+        // the trailing number is only complete at the end of the stream
+        assert_int_equal(docs.size(), 4);
+        parser.finish();
+        assert_int_equal(docs.size(), 5);
+        assert_int_equal(docs[0]->get("a")->toNumber(), 1);
+        assert_int_equal(docs[1]->get(1)->toNumber(), 2);
+        assert_cc_string_equal(docs[2]->toString(), std::string("str"));
+        assert_true(docs[3]->isSection());
+        assert_int_equal(docs[4]->toNumber(), 12);
+
+        // empty stream
+        parser.finish();
+        assert_int_equal(docs.size(), 6);
+        assert_true(docs[5]->isSection());
+    }
+
+    {
+        liblc::ConfigPushParser parser([] (std::shared_ptr<liblc::ConfigObject> root) {});
+        parser.feed("{a = 'unterminated");
+        assert_throws(liblc::ConfigccScannerError, {parser.finish();});
+        parser.reset();
+
+        parser.feed("{a = [1, 2");
+        assert_throws(liblc::ConfigccParserError, {parser.finish();});
+        parser.reset();
+
+        assert_throws(liblc::ConfigccParserError, {parser.feed("{a 1}");});
+        parser.reset();
+
+        assert_throws(liblc::ConfigccParserError, {parser.feed("{a = 1 b = 2}");});
+        parser.reset();
+
+        assert_throws(liblc::ConfigccScannerError, {parser.feed("{a = 1.}");});
+        parser.reset();
+
+        parser.feed("{a = 1}");
+        parser.finish();
+    }
+}
+
+void test_configcc_context(void **state) {
+    liblc::ConfigParseContext context;
+    const std::string doc = "{name = 'admission', limits = [1, 2, 3], rules = [{allow = true}, {allow = false, ratio = -0.5}]}";
+
+    {
+        auto root = context.parse(doc);
+        assert_cc_string_equal(root->get("name")->toString(), std::string("admission"));
+        assert_int_equal(root->get("limits")->toNumberSpan()[2], 3);
+        assert_false(root->get("rules")->get(1)->get("allow")->toBool());
+        assert_float_equal(root->get("rules")->get(1)->get("ratio")->toReal(), -0.5, 0.001);
+    }
+
+    // steady state does not allocate new nodes
+    auto pool = context.getNodePool();
+    size_t allocations = pool->getAllocations();
+    size_t capacity = context.getTokenCapacity();
+    for (int i = 0; i < 10; i++) {
+        auto root = context.parse(doc);
+        assert_true(root->get("rules")->get(0)->get("allow")->toBool());
+    }
+    assert_int_equal(pool->getAllocations(), allocations);
+    assert_int_equal(context.getTokenCapacity(), capacity);
+
+    // container storage comes from the pool as well
+    {
+        auto root = context.parse(doc);
+        assert_true(root->toSection()->get_allocator().resource() == pool.get());
+        assert_true(root->get("rules")->toList()->get_allocator().resource() == pool.get());
+    }
+
+    // blocks freed on other threads are reused
+    {
+        std::vector<std::shared_ptr<liblc::ConfigObject>> roots;
+        for (int i = 0; i < 10; i++) {
+            roots.push_back(context.parse(doc));
+        }
+        allocations = pool->getAllocations();
+        std::thread([&roots]() {
+            roots.clear();
+        }).join();
+        for (int i = 0; i < 10; i++) {
+            roots.push_back(context.parse(doc));
+        }
+        assert_int_equal(pool->getAllocations(), allocations);
+    }
+
+    // trim releases free blocks
+    assert_true(pool->getFreeBlocks() > 0);
+    pool->trim();
+    assert_int_equal(pool->getFreeBlocks(), 0);
+    context.parse(doc);
+    assert_true(pool->getAllocations() > allocations);
+
+    // documents that are still referenced stay valid
+    auto first = context.parse("{a = 1}");
+    auto second = context.parse("{a = 2}");
+    assert_int_equal(first->get("a")->toNumber(), 1);
+    assert_int_equal(second->get("a")->toNumber(), 2);
+    assert_true(first->toSection()->begin()->first.isSame(second->toSection()->begin()->first));
+
+    // tokens referenced by errors are not reused
+    try {
+        context.parse("{a = 1 b}");
+        assert_true(false);
+    } catch (liblc::ConfigccParserError &e) {
+        context.parse("{b = 'overwrite the source'}");
+        assert_cc_string_equal(e.token->getLexeme(), std::string("b"));
+        assert_cc_string_equal(e.token->getSource()->getText(), std::string("{a = 1 b}"));
+    }
+
+    context.reset();
+    assert_true(context.parse("")->isSection());
+
+    // nodes may outlive the context
+    std::shared_ptr<liblc::ConfigObject> root;
+    {
+        liblc::ConfigParseContext scoped;
+        root = scoped.parse(doc);
+    }
+    assert_int_equal(root->get("limits")->getSize(), 3);
+}
+
+#define test_limit_error(input, limits, expectedError) {\
+    try {\
+        liblc::ConfigParser parser(input, "", limits);\
+        parser.parse();\
+        assert_true(false);\
+    } catch (liblc::ConfigccLimitError &e) {\
+        assert_int_equal(e.error, expectedError);\
+    }\
+}
+
+void test_configcc_limits(void **state) {
+    {
+        // nesting does not use the native stack
+        const size_t depth = 200000;
+        std::string input = std::string(depth, '[') + "1" + std::string(depth, ']');
+        liblc::ConfigParser parser(input);
+        auto root = parser.parse();
+
+        liblc::ConfigStringify stringify;
+        assert_cc_string_equal(stringify.stringify(root), input);
+
+        // released without destructor recursion, even on a small stack
+        std::string sections;
+        for (size_t i = 0; i < depth; i++) {
+            sections += "{a=";
+        }
+        sections += "1" + std::string(depth, '}');
+        liblc::ConfigParser sectionParser(sections);
+        std::vector<std::shared_ptr<liblc::ConfigObject>> roots {root, sectionParser.parse()};
+        root.reset();
+
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        pthread_attr_setstacksize(&attributes, 256 * 1024);
+        pthread_t thread;
+        assert_int_equal(pthread_create(&thread, &attributes, [](void *roots) -> void* {
+            static_cast<std::vector<std::shared_ptr<liblc::ConfigObject>>*>(roots)->clear();
+            return nullptr;
+        }, &roots), 0);
+        pthread_join(thread, nullptr);
+        pthread_attr_destroy(&attributes);
+        assert_true(roots.empty());
+    }
+
+    liblc::ConfigLimits limits;
+    limits.maxDepth = 2;
+    test_limit_error("{a = {b = [1]}}", limits, liblc::DEPTH_LIMIT_EXCEEDED);
+    {
+        liblc::ConfigParser parser("{a = {b = 1}, c = [1, 2]}", "", limits);
+        assert_int_equal(parser.parse()->get("a")->get("b")->toNumber(), 1);
+    }
+
+    limits = liblc::ConfigLimits();
+    limits.maxTokens = 9;
+    test_limit_error("{a = 1, b = 2, c = 3}", limits, liblc::TOKEN_LIMIT_EXCEEDED);
+    {
+        liblc::ConfigParser parser("{a = 1, b = 2}", "", limits);
+        assert_int_equal(parser.parse()->get("b")->toNumber(), 2);
+    }
+
+    limits = liblc::ConfigLimits();
+    limits.maxStringLength = 4;
+    test_limit_error("{a = 'abcde'}", limits, liblc::STRING_LIMIT_EXCEEDED);
+    test_limit_error("{abcde = 1}", limits, liblc::STRING_LIMIT_EXCEEDED);
+
+    limits = liblc::ConfigLimits();
+    limits.maxNodes = 4;
+    test_limit_error("[1, 2, 3, 4]", limits, liblc::NODE_LIMIT_EXCEEDED);
+    test_limit_error("{a = [true], b = nil, c = 1}", limits, liblc::NODE_LIMIT_EXCEEDED);
+    {
+        liblc::ConfigParser parser("[1, 2, 3]", "", limits);
+        assert_int_equal(parser.parse()->getSize(), 3);
+    }
+
+    {
+        // reference cycles stop at the depth limit
+        limits = liblc::ConfigLimits();
+        limits.maxDepth = 16;
+        liblc::ConfigParser parser("[[1, true]]");
+        auto root = parser.parse();
+        root->toList()->push_back(root);
+        liblc::ConfigStringify stringify(limits);
+        assert_throws(liblc::ConfigccLimitError, {stringify.stringify(root);});
+        root->toList()->clear();
+    }
+
+    {
+        limits = liblc::ConfigLimits();
+        limits.maxDepth = 2;
+        liblc::ConfigEventHandler handler;
+        liblc::ConfigEventParser events("[[[1]]]", "", limits);
+        assert_throws(liblc::ConfigccLimitError, {events.parse(&handler);});
+
+        liblc::ConfigPushParser push([] (std::shared_ptr<liblc::ConfigObject> root) {});
+        push.setLimits(limits);
+        push.feed("[[1]] [[2]]");
+        assert_throws(liblc::ConfigccLimitError, {push.feed("[[[");});
+    }
+}
+
+// counts bytes and fails above a cap
+class CappedResource: public std::pmr::memory_resource {
+    public:
+        CappedResource(size_t cap): cap(cap) {}
+
+        size_t used = 0;
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            if (used + bytes > cap) {
+                throw std::bad_alloc();
+            }
+            used += bytes;
+            return buffer.allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *block, size_t bytes, size_t alignment) override {
+            used -= bytes;
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+
+        size_t cap;
+        std::pmr::monotonic_buffer_resource buffer;
+};
+
+void test_configcc_memory_resource(void **state) {
+    {
+        CappedResource resource(1 << 20);
+        liblc::ConfigParser parser("{a = [1, 2, 3], b = ['x', {c = true}], d = 1.5}");
+        parser.setMemoryResource(&resource);
+        auto root = parser.parse();
+        assert_true(resource.used > 0);
+
+        assert_true(root->toSection()->get_allocator().resource() == &resource);
+        assert_true(root->get("b")->toList()->get_allocator().resource() == &resource);
+        assert_true(root->get("b")->get(1)->get("c")->toBool());
+
+        // unpacking stays in the resource
+        assert_int_equal(root->get("a")->toNumberSpan()[1], 2);
+        assert_true(root->get("a")->toList()->get_allocator().resource() == &resource);
+        assert_int_equal(root->get("a")->get(2)->toNumber(), 3);
+
+        root.reset();
+        assert_int_equal(resource.used, 0);
+    }
+
+    {
+        // cap per tenant
+        CappedResource resource(4096);
+        std::string input = "[";
+        for (int i = 0; i < 1000; i++) {
+            input += "{a = 1}, ";
+        }
+        input += "]";
+        liblc::ConfigParser parser(input);
+        parser.setMemoryResource(&resource);
+        assert_throws(std::bad_alloc, {parser.parse();});
+    }
+
+    {
+        CappedResource resource(1 << 20);
+        liblc::ConfigParseContext context;
+        context.setMemoryResource(&resource);
+        auto root = context.parse("{name = 'tenant', limits = [1, 2]}");
+        assert_cc_string_equal(root->get("name")->toString(), std::string("tenant"));
+        assert_true(root->toSection()->get_allocator().resource() == &resource);
+    }
+
+    {
+        CappedResource resource(1 << 20);
+        liblc::ConfigScanner scanner("{a = 1}");
+        scanner.setMemoryResource(&resource);
+        assert_int_equal(scanner.scanTokens().size(), 6);
+        assert_true(resource.used > 0);
+    }
+}
+
+void test_configcc_stats(void **state) {
+    liblc::ConfigStats stats;
+    int reports = 0;
+    stats.callback = [&reports] (const liblc::ConfigStats &stats) {
+        reports++;
+    };
+
+    const std::string input = "{a = 1, b = [1.5, 2.5], c = {d = 'x\\ny', e = [true, nil]}}";
+    liblc::ConfigParser parser(input, "", liblc::ConfigLimits(), &stats);
+    auto root = parser.parse();
+    assert_int_equal(reports, 1);
+
+    assert_int_equal(stats.scannedBytes, input.size());
+    assert_int_equal(stats.tokens[liblc::LEFT_BRACE], 2);
+    assert_int_equal(stats.tokens[liblc::REAL_TOKEN], 2);
+    assert_int_equal(stats.tokens[liblc::STRING_TOKEN], 1);
+    assert_int_equal(stats.tokens[liblc::EOF_T], 1);
+    assert_int_equal(stats.nodes[liblc::SECTION], 2);
+    assert_int_equal(stats.nodes[liblc::LIST], 2);
+    assert_int_equal(stats.nodes[liblc::NUMBER], 1);
+    assert_int_equal(stats.nodes[liblc::REAL], 2);
+    assert_int_equal(stats.nodes[liblc::STRING], 1);
+    assert_int_equal(stats.nodes[liblc::BOOLEAN], 1);
+    assert_int_equal(stats.nodes[liblc::NIL], 1);
+    assert_int_equal(stats.maxDepth, 3);
+    assert_true(stats.allocations > 0);
+    assert_true(stats.allocatedBytes > 0);
+    assert_true(stats.scanTime.count() > 0);
+    assert_true(stats.numberTime.count() > 0);
+    assert_true(stats.unescapeTime.count() > 0);
+    assert_true(stats.parseTime.count() > 0);
+
+    liblc::ConfigStringify stringify;
+    stringify.setStats(&stats);
+    auto text = stringify.stringify(root);
+    assert_int_equal(reports, 2);
+    assert_int_equal(stats.stringifiedBytes, text.size());
+    assert_true(stats.stringifyTime.count() > 0);
+
+    // allocations after parsing are not counted
+    size_t allocations = stats.allocations;
+    root->get("c")->get("e")->toList()->push_back(root);
+    root->get("c")->get("e")->toList()->pop_back();
+    assert_int_equal(stats.allocations, allocations);
+
+    stats.reset();
+    assert_int_equal(stats.tokens[liblc::LEFT_BRACE], 0);
+    assert_int_equal(stats.maxDepth, 0);
+
+    liblc::ConfigParseContext context;
+    context.setStats(&stats);
+    context.parse("[1, 2]");
+    assert_int_equal(reports, 3);
+    assert_int_equal(stats.nodes[liblc::NUMBER], 2);
+    assert_int_equal(stats.tokens[liblc::NUMBER_TOKEN], 2);
+
+    // nodes still come from the pool, its free blocks are counted
+    size_t poolAllocations = context.getNodePool()->getAllocations();
+    for (int i = 0; i < 5; i++) {
+        stats.reset();
+        auto list = context.parse("[1, 2]");
+        assert_true(stats.allocations > 0);
+    }
+    assert_int_equal(context.getNodePool()->getAllocations(), poolAllocations);
+
+    // allocations of a caller resource are counted
+    std::pmr::monotonic_buffer_resource resource;
+    liblc::ConfigParser resourceParser("{a = [1, 'x']}");
+    resourceParser.setMemoryResource(&resource);
+    resourceParser.setStats(&stats);
+    stats.reset();
+    auto resourceRoot = resourceParser.parse();
+    assert_true(stats.allocations > 0);
+    assert_true(stats.allocatedBytes > 0);
+    assert_cc_string_equal(resourceRoot->get("a")->get(1)->toString(), std::string("x"));
+}
+
+void test_configcc_locations(void **state) {
+    {
+        liblc::ConfigScanner scanner("{a = 'x\ny',\n  b = 12\r\n}", "loc.cfg");
+        auto tokens = scanner.scanTokens();
+        assert_int_equal(tokens.size(), 10);
+
+        assert_int_equal(tokens[3]->getLine(), 1);
+        assert_int_equal(tokens[3]->getColumn(), 6);
+        assert_cc_string_equal(tokens[3]->getLexeme(), std::string("'x\ny'"));
+
+        assert_int_equal(tokens[5]->getLine(), 3);
+        assert_int_equal(tokens[5]->getColumn(), 3);
+        assert_int_equal(tokens[5]->getTokenStart(), 14);
+        assert_true(tokens[5]->getLexemeView() == "b");
+        assert_cc_string_equal(tokens[5]->getPath(), std::string("loc.cfg"));
+
+        assert_int_equal(tokens[7]->getLine(), 3);
+        assert_int_equal(tokens[7]->getColumn(), 7);
+        assert_int_equal(tokens[8]->getLine(), 4);
+        assert_int_equal(tokens[8]->getColumn(), 1);
+        assert_true(tokens[0]->getSource() == tokens[8]->getSource());
+    }
+    {
+        liblc::ConfigSource source("ab\ncd", "frag.cfg", 10, 100);
+        assert_int_equal(source.getLine(100), 10);
+        assert_int_equal(source.getLine(104), 11);
+        assert_int_equal(source.getColumn(104), 2);
+        assert_true(source.getText(103, 2) == "cd");
+    }
+    {
+        liblc::ConfigPushParser parser([](std::shared_ptr<liblc::ConfigObject>) {}, "push.cfg");
+        parser.feed("{a = 1,\n");
+        try {
+            parser.feed("  b = }");
+            assert_false(true);
+        } catch (liblc::ConfigccParserError &e) {
+            assert_int_equal(e.token->getLine(), 2);
+            assert_int_equal(e.token->getColumn(), 7);
+            assert_int_equal(e.token->getTokenStart(), 14);
+            assert_cc_string_equal(e.token->getLexeme(), std::string("}"));
+            assert_cc_string_equal(e.token->getPath(), std::string("push.cfg"));
+        }
+    }
+    // tokens no longer own copies of their lexeme and path
+    assert_true(sizeof(liblc::Token) <= 64);
+    assert_true(sizeof(liblc::ConfigObject) <= 24);
+}
+
+void test_configcc_index(void **state) {
+    liblc::ConfigParser parser("{backends = ["
+            "{name = 'a', meta = {id = 3}, weight = 0.5},"
+            "{name = 'b', meta = {id = 1}},"
+            "{name = 'c', meta = {id = 2}, weight = 0.5},"
+            "{meta = {id = 'x'}},"
+            "'not a section',"
+            "{name = 'a', meta = {id = 4}}"
+            "], tags = ['x', 'y', 'x']}");
+    liblc::ConfigPublisher publisher(parser.parse());
+    auto snapshot = publisher.load();
+    auto backends = snapshot->getRoot()->get("backends");
+
+    liblc::ConfigStats stats;
+    snapshot->getIndexes().setStats(&stats);
+
+    {
+        auto index = snapshot->getIndex(backends, "name");
+        assert_int_equal(index->getSize(), 4);
+        assert_true(index->find("b") == backends->get(1));
+        assert_true(index->find("missing") == nullptr);
+        assert_int_equal(index->count("a"), 2);
+        auto all = index->findAll("a");
+        assert_int_equal(all.size(), 2);
+        assert_true(all[0] == backends->get(0));
+        assert_true(all[1] == backends->get(5));
+
+        // cached with the snapshot
+        assert_true(snapshot->getIndex(backends, "name") == index);
+        assert_int_equal(stats.indexes, 1);
+        assert_int_equal(stats.indexedEntries, 4);
+    }
+    {
+        auto index = snapshot->getIndex(backends, "meta.id", liblc::INDEX_SORTED);
+        assert_int_equal(index->getSize(), 5);
+        assert_true(index->find(2) == backends->get(2));
+        assert_true(index->find("x") == backends->get(3));
+        auto range = index->findRange(2, 10);
+        assert_int_equal(range.size(), 3);
+        assert_true(range[0] == backends->get(2));
+        assert_true(range[2] == backends->get(5));
+        assert_int_equal(stats.indexes, 2);
+    }
+    {
+        auto index = snapshot->getIndex(backends, "weight");
+        assert_int_equal(index->count(0.5), 2);
+        assert_int_equal(index->findRange(0, 1).size(), 2);
+        assert_true(index->findRange(0, 1)[1] == backends->get(2));
+    }
+    {
+        auto tags = snapshot->getRoot()->get("tags");
+        liblc::ConfigIndex index(tags, "", liblc::INDEX_SORTED);
+        assert_int_equal(index.count("x"), 2);
+        assert_int_equal(index.count("y"), 1);
+    }
+    assert_int_equal(snapshot->getIndexes().getSize(), 3);
+    snapshot->getIndexes().setStats(nullptr);
+
+    // packed lists are indexed by value
+    {
+        liblc::ConfigParser packedParser("{ids = [10, 20, 30, 20], ratios = [0.1, 0.5]}");
+        auto root = packedParser.parse();
+        auto ids = root->get("ids");
+        assert_true(ids->isPacked());
+        liblc::ConfigIndex index(ids, "");
+        assert_int_equal(index.getSize(), 4);
+        assert_true(ids->isPacked());
+        assert_int_equal(index.count(20), 2);
+        assert_int_equal(index.find(30)->toNumber(), 30);
+        assert_true(index.find(40) == nullptr);
+        assert_int_equal(liblc::ConfigIndex(ids, "id").getSize(), 0);
+
+        // double keys match the stored reals
+        liblc::ConfigIndex reals(root->get("ratios"), "", liblc::INDEX_SORTED);
+        assert_true(reals.find(0.1) != nullptr);
+        assert_int_equal(reals.findRange(0.1, 0.5).size(), 1);
+    }
+
+    // concurrent requests build an index once
+    {
+        liblc::ConfigIndexCache cache;
+        cache.setStats(&stats);
+        stats.reset();
+        std::vector<std::shared_ptr<const liblc::ConfigIndex>> found(4);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < found.size(); i++) {
+            threads.emplace_back([&, i]() {
+                found[i] = cache.get(backends, "name");
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        for (auto &index : found) {
+            assert_true(index == found[0]);
+        }
+        assert_int_equal(stats.indexes, 1);
+        assert_int_equal(cache.getSize(), 1);
+    }
+}
@@ -23,4 +23,34 @@ void test_configcc(void **state);
 
 void test_configcc_failure(void **state);
 
+void test_configcc_events(void **state);
+
+void test_configcc_schema(void **state);
+
+void test_configcc_packed(void **state);
+
+void test_configcc_keys(void **state);
+
+void test_configcc_snapshot(void **state);
+
+void test_configcc_include(void **state);
+
+void test_configcc_merge(void **state);
+
+void test_configcc_writer(void **state);
+
+void test_configcc_push(void **state);
+
+void test_configcc_context(void **state);
+
+void test_configcc_limits(void **state);
+
+void test_configcc_memory_resource(void **state);
+
+void test_configcc_stats(void **state);
+
+void test_configcc_locations(void **state);
+
+void test_configcc_index(void **state);
+
 #endif
@@ -0,0 +1,90 @@
+#include "configflat.h"
+#include "test_configflat.h"
+
+void test_configflat(void **state) {
+    liblc::ConfigParser parser("{"
+            "servers = [{host = 'a', port = 80}, {host = 'b', port = 81, tags = []}],"
+            "limits = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11],"
+            "ratios = [0.5, 1.5],"
+            "'odd.key' = {'it\\'s' = true},"
+            "empty = {},"
+            "nothing = nil"
+            "}");
+    auto root = parser.parse();
+    liblc::ConfigFlat flat(root);
+
+    // 4 server values, empty tags, 11 limits, 2 ratios, odd key, empty, nothing
+    assert_int_equal(flat.getSize(), 21);
+    for (size_t i = 1; i < flat.getSize(); i++) {
+        assert_true(flat[i-1].getPath() < flat[i].getPath());
+    }
+
+    auto port = flat.find("servers[1].port");
+    assert_true(port.has_value());
+    assert_int_equal(port->toNumber(), 81);
+    assert_true(flat.find("servers[1].host")->toString() == "b");
+    assert_float_equal(flat.find("ratios[1]")->toReal(), 1.5, 0.001);
+    assert_true(flat.find("['odd.key']['it\\'s']")->toBool());
+    assert_int_equal(flat.find("servers[1].tags")->getType(), liblc::LIST);
+    assert_int_equal(flat.find("empty")->getType(), liblc::SECTION);
+    assert_int_equal(flat.find("nothing")->getType(), liblc::NIL);
+    assert_false(flat.find("servers[2].port").has_value());
+    assert_false(flat.find("servers").has_value());
+
+    auto servers = flat.scan("servers[0].");
+    assert_int_equal(servers.size(), 2);
+    assert_true((*servers.begin()).getPath() == "servers[0].host");
+    auto it = servers.begin();
+    assert_true((it++)->getPath() == "servers[0].host");
+    assert_true(it->getPath() == "servers[0].port");
+    static_assert(std::is_same<std::iterator_traits<liblc::ConfigFlatIterator>::iterator_category,
+            std::input_iterator_tag>::value);
+    std::vector<liblc::ConfigFlatEntry> entries(servers.begin(), servers.end());
+    assert_int_equal(entries.size(), 2);
+    assert_int_equal(flat.scan("limits[").size(), 11);
+    // bytewise order
+    assert_true(flat.scan("limits[").begin()[1].getPath() == "limits[10]");
+    assert_int_equal(flat.scan("missing").size(), 0);
+    assert_int_equal(flat.scan("").size(), flat.getSize());
+
+    // unflatten restores the document including packed lists
+    auto restored = flat.unflatten();
+    liblc::ConfigStringify stringify;
+    assert_cc_string_equal(stringify.stringify(restored), stringify.stringify(root));
+    assert_true(restored->get("limits")->isPacked());
+    assert_true(liblc::ConfigFlat(restored) == flat);
+
+    liblc::ConfigParser changedParser("{"
+            "servers = [{host = 'a', port = 80}, {host = 'c', port = 81, tags = []}],"
+            "limits = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11],"
+            "ratios = [0.5, 1.5],"
+            "'odd.key' = {'it\\'s' = true},"
+            "empty = {},"
+            "added = 1"
+            "}");
+    liblc::ConfigFlat changed(changedParser.parse());
+    assert_true(changed != flat);
+    std::vector<std::string> paths;
+    assert_int_equal(flat.diff(changed, [&](std::string_view path, const liblc::ConfigFlatEntry *before,
+                    const liblc::ConfigFlatEntry *after) {
+                paths.push_back(std::string(path));
+                if (path == "added") {
+                    assert_true(before == nullptr);
+                    assert_int_equal(after->toNumber(), 1);
+                } else if (path == "nothing") {
+                    assert_true(after == nullptr);
+                } else {
+                    assert_true(before->toString() == "b");
+                    assert_true(after->toString() == "c");
+                }
+            }), 3);
+    assert_int_equal(paths.size(), 3);
+    assert_cc_string_equal(paths[0], std::string("added"));
+    assert_int_equal(flat.diff(flat), 0);
+
+    liblc::ConfigParser listParser("[{a = 1}, 'x']");
+    auto list = listParser.parse();
+    liblc::ConfigFlat listFlat(list);
+    assert_true(listFlat[0].getPath() == "[0].a");
+    assert_cc_string_equal(stringify.stringify(listFlat.unflatten()), stringify.stringify(list));
+}
@@ -0,0 +1,14 @@
+#ifndef __TEST_CC_CONFIGFLAT_H__
+#define __TEST_CC_CONFIGFLAT_H__
+
+#include "macros.h"
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+void test_configflat(void **state);
+
+#endif
@@ -0,0 +1,124 @@
+#include "configparallel.h"
+#include "test_configparallel.h"
+#include <sstream>
+
+struct TestTotals {
+    long nodes = 0;
+    double sum = 0;
+    long strings = 0;
+};
+
+class TestTotalsVisitor: public liblc::ConfigParallelVisitor<TestTotals> {
+    public:
+        TestTotals visitNumber(liblc::ConfigNumber value) const override {
+            return TestTotals { 1, (double)value, 0 };
+        }
+
+        TestTotals visitReal(liblc::ConfigReal value) const override {
+            return TestTotals { 1, value, 0 };
+        }
+
+        TestTotals visitString(const liblc::ConfigString &value) const override {
+            return TestTotals { 1, 0, 1 };
+        }
+
+        TestTotals visitSection(const liblc::ConfigObject &section) const override {
+            return TestTotals { 1, 0, 0 };
+        }
+
+        TestTotals visitList(const liblc::ConfigObject &list) const override {
+            return TestTotals { 1, 0, 0 };
+        }
+
+        TestTotals reduce(const TestTotals &a, const TestTotals &b) const override {
+            return TestTotals { a.nodes + b.nodes, a.sum + b.sum, a.strings + b.strings };
+        }
+};
+
+// not commutative, checks that results are combined in document order
+class TestOrderVisitor: public liblc::ConfigParallelVisitor<std::string> {
+    public:
+        std::string visitNumber(liblc::ConfigNumber value) const override {
+            return std::to_string(value) + ",";
+        }
+
+        std::string visitKey(const liblc::ConfigKey &key) const override {
+            return key.str() + "=";
+        }
+
+        std::string reduce(const std::string &a, const std::string &b) const override {
+            return a + b;
+        }
+};
+
+class TestFailingVisitor: public liblc::ConfigParallelVisitor<int> {
+    public:
+        int visitNumber(liblc::ConfigNumber value) const override {
+            if (value == 777) {
+                throw liblc::ConfigccOutOfBounds();
+            }
+            return 1;
+        }
+
+        int reduce(const int &a, const int &b) const override {
+            return a + b;
+        }
+};
+
+static std::shared_ptr<liblc::ConfigObject> testDocument() {
+    std::stringstream input;
+    input << "{items = [";
+    for (int i = 0; i < 2000; i++) {
+        input << "{id = " << i << ", name = 'n', weights = [1, 2, 3], ratio = 0.5},";
+    }
+    input << "], packed = [";
+    for (int i = 0; i < 10000; i++) {
+        input << i << ",";
+    }
+    input << "]}";
+    liblc::ConfigParser parser(input.str());
+    return parser.parse();
+}
+
+void test_configparallel(void **state) {
+    auto root = testDocument();
+    TestTotalsVisitor visitor;
+
+    liblc::ConfigTaskPool sequential(0);
+    auto expected = liblc::ConfigMapReduce<TestTotals>(sequential, visitor).run(root);
+    // root, 2 lists, 2000 sections with 4 values and a list of 3, 10000 packed values
+    assert_int_equal(expected.nodes, 3 + 2000 * 8 + 10000);
+    assert_int_equal(expected.strings, 2000);
+
+    liblc::ConfigTaskPool pool(4);
+    assert_int_equal(pool.getWorkers(), 4);
+    for (size_t grain : {1, 16, 4096}) {
+        auto totals = liblc::ConfigMapReduce<TestTotals>(pool, visitor, grain).run(root);
+        assert_int_equal(totals.nodes, expected.nodes);
+        assert_float_equal(totals.sum, expected.sum, 0.001);
+        assert_int_equal(totals.strings, expected.strings);
+    }
+
+    liblc::ConfigParser parser("{b = [1, 2, {c = 3, a = 4}], a = [5, 6, 7, 8]}");
+    auto small = parser.parse();
+    TestOrderVisitor order;
+    auto text = liblc::ConfigMapReduce<std::string>(pool, order, 1).run(small);
+    assert_cc_string_equal(text, std::string("a=5,6,7,8,b=1,2,a=4,c=3,"));
+    assert_cc_string_equal(liblc::ConfigMapReduce<std::string>(sequential, order).run(small), text);
+}
+
+void test_configparallel_failure(void **state) {
+    liblc::ConfigParser parser("{a = [1, 2, 777, 4, 5, 6, 7, 8], b = {c = 1}}");
+    auto root = parser.parse();
+    liblc::ConfigTaskPool pool(2);
+    TestFailingVisitor visitor;
+    try {
+        liblc::ConfigMapReduce<int>(pool, visitor, 1).run(root);
+        assert_false(true);
+    } catch (liblc::ConfigccOutOfBounds &e) {
+    }
+
+    // the pool is still usable
+    liblc::ConfigParser other("{a = [1, 2, 3]}");
+    assert_int_equal(liblc::ConfigMapReduce<int>(pool, visitor, 1).run(other.parse()), 3);
+}
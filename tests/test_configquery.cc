@@ -0,0 +1,125 @@
+#include "configquery.h"
+#include "test_configquery.h"
+
+static std::vector<std::string> queryStrings(liblc::ConfigQuery &query, std::shared_ptr<liblc::ConfigObject> root) {
+    std::vector<std::string> result;
+    for (auto &match : query.select(root)) {
+        result.push_back(match.toString());
+    }
+    return result;
+}
+
+void test_configquery(void **state) {
+    liblc::ConfigParser parser("{"
+            "servers = ["
+            "  {name = 'a', region = 'eu', port = 80, tls = {port = 443}},"
+            "  {name = 'b', region = 'us', port = 8080},"
+            "  {name = 'c', region = 'eu', port = 9000, weight = 0.5}"
+            "],"
+            "ports = [1, 22, 1000, 2000],"
+            "'odd key' = 'x',"
+            "enabled = true"
+            "}");
+    auto root = parser.parse();
+
+    {
+        liblc::ConfigQuery query("servers[*].port");
+        std::vector<int> ports;
+        for (auto &match : query.select(root)) {
+            ports.push_back(match.toNumber());
+        }
+        assert_int_equal(ports.size(), 3);
+        assert_int_equal(ports[0], 80);
+        assert_int_equal(ports[2], 9000);
+
+        // runs again with the same result
+        assert_int_equal(query.count(*root), 3);
+        assert_true(query.first(*root).getObject() == root->get("servers")->get(0)->get("port").get());
+    }
+    {
+        liblc::ConfigQuery query("servers..port");
+        assert_int_equal(query.count(*root), 4);
+        liblc::ConfigQuery all("..port");
+        assert_int_equal(all.count(*root), 4);
+    }
+    {
+        liblc::ConfigQuery query("servers[?region == 'eu'].name");
+        auto names = queryStrings(query, root);
+        assert_int_equal(names.size(), 2);
+        assert_cc_string_equal(names[0], std::string("a"));
+        assert_cc_string_equal(names[1], std::string("c"));
+
+        liblc::ConfigQuery numbers("servers[?port >= 8080].name");
+        assert_int_equal(numbers.count(*root), 2);
+        liblc::ConfigQuery exists("servers[?weight].name");
+        assert_cc_string_equal(exists.first(*root).toString(), std::string("c"));
+        liblc::ConfigQuery real("servers[?weight == 0.5]");
+        assert_int_equal(real.count(*root), 1);
+        liblc::ConfigQuery notEqual("servers[?region != 'eu'].name");
+        assert_cc_string_equal(notEqual.first(*root).toString(), std::string("b"));
+        liblc::ConfigQuery mismatch("servers[?region > 1]");
+        assert_int_equal(mismatch.count(*root), 0);
+    }
+    {
+        liblc::ConfigQuery last("servers[-1].name");
+        assert_cc_string_equal(last.first(*root).toString(), std::string("c"));
+        liblc::ConfigQuery range("servers[1:].name");
+        assert_int_equal(range.count(*root), 2);
+        liblc::ConfigQuery head("servers[:1].name");
+        assert_int_equal(head.count(*root), 1);
+        liblc::ConfigQuery outside("servers[5]");
+        assert_int_equal(outside.count(*root), 0);
+    }
+    {
+        // packed elements are referenced by index
+        assert_true(root->get("ports")->isPacked());
+        liblc::ConfigQuery query("ports[?@ > 500]");
+        std::vector<int> ports;
+        for (auto &match : query.select(root)) {
+            assert_true(match.isPackedElement());
+            ports.push_back(match.toNumber());
+        }
+        assert_int_equal(ports.size(), 2);
+        assert_int_equal(ports[0], 1000);
+        assert_int_equal(ports[1], 2000);
+
+        liblc::ConfigQuery second("ports[1]");
+        assert_int_equal(second.first(*root).getIndex(), 1);
+        assert_float_equal(second.first(*root).toReal(), 22, 0.001);
+    }
+    {
+        liblc::ConfigQuery quoted("['odd key']");
+        assert_cc_string_equal(quoted.first(*root).toString(), std::string("x"));
+        liblc::ConfigQuery flag("*");
+        assert_int_equal(flag.count(*root), 4);
+        liblc::ConfigQuery empty("");
+        assert_true(empty.first(*root).getObject() == root.get());
+        liblc::ConfigQuery missing("servers[*].missing");
+        assert_int_equal(missing.count(*root), 0);
+        try {
+            missing.first(*root);
+            assert_false(true);
+        } catch (liblc::ConfigccKeyNotFound &e) {
+        }
+    }
+}
+
+#define test_query_error(text, expected) {\
+    try {\
+        liblc::ConfigQuery query(text);\
+        assert_false(true);\
+    } catch (liblc::ConfigccQueryError &e) {\
+        assert_int_equal(e.error, liblc::INVALID_QUERY);\
+        assert_int_equal(e.position, expected);\
+    }\
+}
+
+void test_configquery_errors(void **state) {
+    test_query_error("a.", 2);
+    test_query_error("a[1", 3);
+    test_query_error("a[?b ~ 1]", 5);
+    test_query_error("a[?b == maybe]", 8);
+    test_query_error("a['b]", 5);
+    test_query_error("a b", 1);
+    test_query_error("a[?]", 3);
+}
@@ -0,0 +1,120 @@
+#include "configwatch.h"
+#include "test_configwatch.h"
+#include <condition_variable>
+
+class TestWatchHandler: public liblc::ConfigWatchHandler {
+    public:
+        virtual void onReload(const std::string &path, std::shared_ptr<liblc::ConfigObject> root) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (root->getSize() == 0) {
+                // truncated while writing
+                return;
+            }
+            reloads++;
+            threads.insert(std::this_thread::get_id());
+            lastValue = root->get("a")->toNumber();
+            changed.notify_all();
+            if (lastValue < 0) {
+                throw std::runtime_error("negative");
+            }
+        }
+
+        virtual void onError(const std::string &path, const liblc::ConfigparseCommonException &error) {
+            std::lock_guard<std::mutex> lock(mutex);
+            errors++;
+            errorPath = error.token->getPath();
+            errorLine = error.token->getLine();
+            changed.notify_all();
+        }
+
+        virtual void onException(const std::string &path, std::exception_ptr error) {
+            std::lock_guard<std::mutex> lock(mutex);
+            try {
+                std::rethrow_exception(error);
+            } catch (std::runtime_error &e) {
+                exceptions++;
+            }
+            changed.notify_all();
+        }
+
+        bool waitFor(int expectedReloads, int expectedErrors) {
+            std::unique_lock<std::mutex> lock(mutex);
+            return changed.wait_for(lock, std::chrono::seconds(5), [&]() {
+                return reloads >= expectedReloads && errors >= expectedErrors;
+            });
+        }
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        int reloads = 0;
+        int errors = 0;
+        int exceptions = 0;
+        int lastValue = 0;
+        std::set<std::thread::id> threads;
+        std::string errorPath;
+        int errorLine = 0;
+};
+
+static void writeFile(std::string path, std::string content) {
+    std::ofstream file(path);
+    file << content;
+}
+
+void test_configwatch(void **state) {
+    char dir[] = "/tmp/configwatch_XXXXXX";
+    assert_non_null(mkdtemp(dir));
+    std::string path = std::string(dir) + "/test.cfg";
+    writeFile(path, "{a=1}");
+
+    TestWatchHandler handler;
+    {
+        liblc::ConfigWatcher watcher(&handler, std::chrono::milliseconds(20));
+        watcher.addPath(path);
+        watcher.start();
+        assert_true(handler.waitFor(1, 0));
+        assert_int_equal(handler.lastValue, 1);
+        // the first parse happens on the watcher's thread as well
+        assert_true(handler.threads.count(std::this_thread::get_id()) == 0);
+
+        writeFile(path, "{a=2}");
+        assert_true(handler.waitFor(2, 0));
+        assert_int_equal(handler.lastValue, 2);
+
+        // same content is not parsed again
+        writeFile(path, "{a=2}");
+        writeFile(path, "{\na=3 b}");
+        assert_true(handler.waitFor(2, 1));
+        assert_int_equal(handler.reloads, 2);
+        assert_cc_string_equal(handler.errorPath, path);
+        assert_int_equal(handler.errorLine, 2);
+
+        // replaced by rename
+        std::string tmpPath = std::string(dir) + "/test.tmp";
+        writeFile(tmpPath, "{a=4}");
+        rename(tmpPath.c_str(), path.c_str());
+        assert_true(handler.waitFor(3, 1));
+        assert_int_equal(handler.lastValue, 4);
+
+        // handler exceptions are reported and watching continues
+        writeFile(path, "{a=-1}");
+        assert_true(handler.waitFor(4, 1));
+        writeFile(path, "{a=5}");
+        assert_true(handler.waitFor(5, 1));
+        assert_int_equal(handler.exceptions, 1);
+        assert_int_equal(handler.lastValue, 5);
+
+        // restarted watchers keep running
+        watcher.stop();
+        watcher.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        writeFile(path, "{a=6}");
+        assert_true(handler.waitFor(6, 1));
+        assert_int_equal(handler.lastValue, 6);
+        watcher.stop();
+        watcher.stop();
+        assert_true(handler.threads.count(std::this_thread::get_id()) == 0);
+    }
+
+    unlink(path.c_str());
+    rmdir(dir);
+}
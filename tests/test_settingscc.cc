@@ -0,0 +1,121 @@
+#include "settingscc.h"
+#include "test_settingscc.h"
+#include <any>
+
+void test_settingscc(void **state) {
+    auto schema = std::make_shared<liblc::SettingsSchema>();
+    auto host = schema->addSetting("host", liblc::STRING, std::string("localhost"), "", "server.host");
+    auto port = schema->addSetting("port", liblc::NUMBER, 80, "SETTINGSCC_TEST_PORT", "server.port");
+    auto ratio = schema->addSetting("ratio", liblc::REAL, 0.5f, "", "ratio", "-ratio");
+    auto verbose = schema->addSetting("verbose", liblc::BOOLEAN, false, "SETTINGSCC_TEST_VERBOSE");
+    auto first = schema->addSetting("first", liblc::NUMBER, 0, "", "list.0");
+    auto missing = schema->addSetting("missing", liblc::STRING);
+
+    liblc::Argparse parser("Unit test");
+    parser.addArgument("-ratio", liblc::REAL, 1, "ratio");
+    parser.addArgument("port", liblc::NUMBER, 1, "port");
+
+    liblc::ConfigParser configParser("{server={host='example.com', port=8080}, ratio=0.25, list=[7, 8]}");
+    auto config = configParser.parse();
+
+    setenv("SETTINGSCC_TEST_PORT", "9090", 1);
+    setenv("SETTINGSCC_TEST_VERBOSE", "true", 1);
+
+    liblc::SettingsResolver resolver(schema);
+    {
+        int argc = 3;
+        const char *argv[] = {
+            "test",
+            "-ratio", "0.75"
+        };
+        liblc::Args args = parser.parse(argc, (char**)argv);
+        auto settings = resolver.resolve(&args, config);
+
+        assert_int_equal(settings->getSize(), 6);
+
+        assert_cc_string_equal(settings->toString(host), std::string("example.com"));
+        assert_int_equal(settings->getSource(host), liblc::SETTING_CONFIG);
+
+        assert_int_equal(settings->toNumber(port), 9090);
+        assert_int_equal(settings->getSource(port), liblc::SETTING_ENV);
+
+        assert_float_equal(settings->toReal(ratio), 0.75, 0.001);
+        assert_int_equal(settings->getSource(ratio), liblc::SETTING_ARGV);
+
+        assert_true(settings->toBool(verbose));
+        assert_int_equal(settings->toNumber(first), 7);
+
+        assert_true(settings->isNil(missing));
+        assert_int_equal(settings->getSource(missing), liblc::SETTING_DEFAULT);
+    }
+
+    unsetenv("SETTINGSCC_TEST_PORT");
+    unsetenv("SETTINGSCC_TEST_VERBOSE");
+    {
+        int argc = 3;
+        const char *argv[] = {
+            "test",
+            "port", "1234"
+        };
+        liblc::Args args = parser.parse(argc, (char**)argv);
+        auto settings = resolver.resolve(&args);
+
+        assert_cc_string_equal(settings->toString(schema->indexOf("host")), std::string("localhost"));
+        assert_int_equal(settings->toNumber(port), 1234);
+        assert_float_equal(settings->toReal(ratio), 0.5, 0.001);
+        assert_false(settings->toBool(verbose));
+    }
+}
+
+void test_settingscc_failure(void **state) {
+    auto schema = std::make_shared<liblc::SettingsSchema>();
+    auto port = schema->addSetting("port", liblc::NUMBER, 80, "SETTINGSCC_TEST_PORT", "port");
+    liblc::SettingsResolver resolver(schema);
+
+    assert_throws(liblc::SettingsUnknownSetting, {schema->indexOf("host");});
+
+    {
+        liblc::ConfigParser configParser("{port='80'}");
+        auto config = configParser.parse();
+        assert_throws(liblc::SettingsTypeException, {resolver.resolve(nullptr, config);});
+    }
+
+    {
+        liblc::ConfigParser configParser("{port=80.5}");
+        auto config = configParser.parse();
+        assert_throws(liblc::SettingsTypeException, {resolver.resolve(nullptr, config);});
+    }
+
+    // values are not truncated
+    for (auto value : std::vector<std::string> {"eighty", "8080abc", "4294967297", "", "0x"}) {
+        setenv("SETTINGSCC_TEST_PORT", value.c_str(), 1);
+        assert_throws(liblc::SettingsTypeException, {resolver.resolve(nullptr);});
+        unsetenv("SETTINGSCC_TEST_PORT");
+    }
+
+    {
+        auto ratioSchema = std::make_shared<liblc::SettingsSchema>();
+        ratioSchema->addSetting("ratio", liblc::REAL, 0.5f, "SETTINGSCC_TEST_RATIO");
+        liblc::SettingsResolver ratioResolver(ratioSchema);
+        setenv("SETTINGSCC_TEST_RATIO", "0.25x", 1);
+        assert_throws(liblc::SettingsTypeException, {ratioResolver.resolve(nullptr);});
+        setenv("SETTINGSCC_TEST_RATIO", "0.25", 1);
+        assert_float_equal(ratioResolver.resolve(nullptr)->toReal(0), 0.25, 0.001);
+        unsetenv("SETTINGSCC_TEST_RATIO");
+    }
+
+    {
+        auto settings = resolver.resolve(nullptr);
+        try {
+            settings->toString(port);
+            assert_false(true);
+        } catch (liblc::SettingsTypeException &e) {
+            assert_cc_string_equal(std::string(e.what()), std::string("Unexpected type for setting port"));
+        }
+    }
+
+    // defaults have to match the declared type
+    assert_throws(liblc::SettingsTypeException, {schema->addSetting("ratio", liblc::REAL, 1);});
+    assert_throws(liblc::SettingsTypeException, {schema->addSetting("name", liblc::STRING, false);});
+    schema->addSetting("optional", liblc::NUMBER, nullptr);
+}